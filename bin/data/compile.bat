@@ -1,2 +1,4 @@
 C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe main.vert -o main.vert.spv
-C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe main.frag -o main.frag.spv
\ No newline at end of file
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe main.frag -o main.frag.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe main_push.vert -o main_push.vert.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe main_push.frag -o main_push.frag.spv
\ No newline at end of file
@@ -9,10 +9,11 @@ layout(set=0, binding = 0) uniform UniformCamera {
     mat4 view;
 } u_camera;
 
-layout(set=1, binding = 1) uniform UniformModel {
-    mat4 model;
-} u_model;
+// one transform per paddle/ball, indexed by the instance being drawn
+layout(std430, set=1, binding = 0) readonly buffer InstanceBuffer {
+    mat4 models[];
+} u_instances;
 
 void main() {
-    gl_Position = u_camera.proj * u_camera.view * u_model.model * vec4(vertices, 1.0);
+    gl_Position = u_camera.proj * u_camera.view * u_instances.models[gl_InstanceIndex] * vec4(vertices, 1.0);
 }
\ No newline at end of file
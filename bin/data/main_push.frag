@@ -0,0 +1,10 @@
+#version 450
+
+
+layout(location = 0) in vec4 v_color;
+
+layout(location = 0) out vec4 out_Color;
+
+void main() {
+    out_Color = v_color;
+}
\ No newline at end of file
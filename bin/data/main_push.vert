@@ -0,0 +1,24 @@
+#version 450
+
+// attributes
+layout(location = 0) in vec3 vertices;
+
+// uniforms
+layout(set=0, binding = 0) uniform UniformCamera {
+    mat4 proj;
+    mat4 view;
+} u_camera;
+
+// pushed right before each paddle/ball is drawn
+layout(push_constant) uniform PushQuad {
+    vec2 position;
+    vec2 size;
+    vec4 color;
+} u_quad;
+
+layout(location = 0) out vec4 v_color;
+
+void main() {
+    v_color = u_quad.color;
+    gl_Position = u_camera.proj * u_camera.view * vec4(vertices.xy * u_quad.size + u_quad.position, vertices.z, 1.0);
+}
\ No newline at end of file
@@ -1,21 +1,47 @@
 #include "sys.h"
 
+#ifdef _WIN32
+// 1ms scheduler granularity for the frame pacer's sleeps
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
 static app::Config* g_config = nullptr;
 static SDL_Window* g_window = nullptr;
 static bool g_running = true;
+static float g_alpha = 1.0f;
+
+// Frame Pacing
+static std::chrono::steady_clock::time_point g_deadline;
+// Running estimate of how long a 1ms sleep really takes, mean and variance
+static double g_sleepMean = 0.002;
+static double g_sleepM2 = 0.0;
+static uint64_t g_sleepCount = 1;
+
+static void paceFrame();
+static void sleepUntil(std::chrono::steady_clock::time_point t);
 
 void app::init(Config* config) {
 	g_config = config;
 
-	SDL_Init(SDL_INIT_EVERYTHING);
+#ifdef _WIN32
+	timeBeginPeriod(1);
+#endif
 
-	g_window = SDL_CreateWindow(
-		g_config->caption.c_str(),
-		SDL_WINDOWPOS_UNDEFINED,
-		SDL_WINDOWPOS_UNDEFINED,
-		g_config->width,
-		g_config->height,
-		SDL_WINDOW_SHOWN);
+	if (g_config->headless) {
+		SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS);
+	}
+	else {
+		SDL_Init(SDL_INIT_EVERYTHING);
+
+		g_window = SDL_CreateWindow(
+			g_config->caption.c_str(),
+			SDL_WINDOWPOS_UNDEFINED,
+			SDL_WINDOWPOS_UNDEFINED,
+			g_config->width,
+			g_config->height,
+			SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+	}
 
 	//input::init();
 
@@ -27,20 +53,47 @@ void app::init(Config* config) {
 void app::update() {
 	SDL_Event e;
 
-	uint32_t pre = SDL_GetTicks();
-	uint32_t curr = 0;
+	g_deadline = std::chrono::steady_clock::now();
+
+	std::chrono::steady_clock::time_point pre = std::chrono::steady_clock::now();
 	float delta = 0.0f;
+	double accumulator = 0.0;
+
+	uint32_t frame = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
 	while (g_running) {
 
-		curr = SDL_GetTicks();
-		delta = (curr - pre) / 1000.0f;
-		pre = curr;
+		if (g_config->headless) {
+			// Fixed so a headless run does the same work on every machine
+			if (frame == g_config->frames) {
+				break;
+			}
+			delta = 1.0f / 60.0f;
+		}
+		else {
+			paceFrame();
+
+			if (g_config->waitFrameCB) {
+				g_config->waitFrameCB();
+			}
+
+			std::chrono::steady_clock::time_point curr = std::chrono::steady_clock::now();
+			delta = std::chrono::duration<float>(curr - pre).count();
+			pre = curr;
+		}
+
+		frame++;
 
 		while (SDL_PollEvent(&e)) {
 			if (e.type == SDL_QUIT) {
 				g_running = false;
 			}
+			else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+				// Used for the swapchain extent when the surface leaves it to us
+				g_config->width = e.window.data1;
+				g_config->height = e.window.data2;
+			}
 
 			//input::doEvent(e);
 
@@ -49,8 +102,28 @@ void app::update() {
 			}
 		}
 
-		if (g_config->updateCB) {
-			g_config->updateCB(delta);
+		if (g_config->tickRate > 0.0f) {
+			double tick = 1.0 / g_config->tickRate;
+
+			// After a long stall (a window drag, a breakpoint) the missed
+			// time is dropped instead of being simulated all at once.
+			accumulator += std::min((double)delta, 0.25);
+
+			while (accumulator >= tick) {
+				if (g_config->updateCB) {
+					g_config->updateCB((float)tick);
+				}
+				accumulator -= tick;
+			}
+
+			g_alpha = (float)(accumulator / tick);
+		}
+		else {
+			if (g_config->updateCB) {
+				g_config->updateCB(delta);
+			}
+
+			g_alpha = 1.0f;
 		}
 
 		if (g_config->renderCB) {
@@ -62,6 +135,13 @@ void app::update() {
 			g_config->postUpdate();
 		}
 	}
+
+	if (g_config->headless) {
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "Headless: " << frame << " frames in " << ms << " ms ("
+			<< ((frame > 0) ? ms / frame : 0.0) << " ms/frame)" << std::endl;
+	}
 }
 
 void app::release() {
@@ -69,8 +149,14 @@ void app::release() {
 		g_config->releaseCB();
 	}
 
-	SDL_DestroyWindow(g_window);
+	if (g_window) {
+		SDL_DestroyWindow(g_window);
+	}
 	SDL_Quit();
+
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
 }
 
 uint32_t app::getWidth() {
@@ -85,6 +171,61 @@ SDL_Window* app::getWindow() {
 	return g_window;
 }
 
+float app::getAlpha() {
+	return g_alpha;
+}
+
+static void paceFrame() {
+	if (g_config->targetFrameTime <= 0.0f) {
+		return;
+	}
+
+	std::chrono::steady_clock::duration target = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<float>(g_config->targetFrameTime));
+
+	g_deadline += target;
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	// Too far behind to catch up, start over from now instead of rushing
+	// a burst of frames out.
+	if (now > g_deadline + target) {
+		g_deadline = now;
+		return;
+	}
+
+	sleepUntil(g_deadline);
+}
+
+// Sleeps in 1ms steps while the time left is more than a step is expected
+// to take, learning that from every step taken. Only the last fraction of
+// a millisecond is spent yielding.
+static void sleepUntil(std::chrono::steady_clock::time_point t) {
+	while (true) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		double remaining = std::chrono::duration<double>(t - start).count();
+		double estimate = g_sleepMean + std::sqrt(g_sleepM2 / g_sleepCount);
+
+		if (remaining <= estimate) {
+			break;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		double observed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		g_sleepCount++;
+		double d = observed - g_sleepMean;
+		g_sleepMean += d / g_sleepCount;
+		g_sleepM2 += d * (observed - g_sleepMean);
+	}
+
+	while (std::chrono::steady_clock::now() < t) {
+		std::this_thread::yield();
+	}
+}
+
 void app::exit() {
 	g_running = false;
 }
\ No newline at end of file
@@ -4,30 +4,88 @@
 
 int main(int argc, char** argv) {
 
-	pong::AiPlayerType type = pong::AiPlayerType::AI_PLAYER_EASY;
+	pong::Options options;
 
-	if (argc == 2) {
-		std::string cmd(argv[1]);
+	for (int i = 1; i < argc; i++) {
+		std::string cmd(argv[i]);
 
 		if (cmd == "easy") {
-			type = pong::AiPlayerType::AI_PLAYER_EASY;
+			options.aiPlayerType = pong::AiPlayerType::AI_PLAYER_EASY;
 		}
 		else if (cmd == "normal") {
-			type = pong::AiPlayerType::AI_PLAYER_NORMAL;
+			options.aiPlayerType = pong::AiPlayerType::AI_PLAYER_NORMAL;
 		}
 		else if (cmd == "hard") {
-			type = pong::AiPlayerType::AI_PLAYER_HARD;
+			options.aiPlayerType = pong::AiPlayerType::AI_PLAYER_HARD;
 		}
 		else if (cmd == "expert") {
-			type = pong::AiPlayerType::AI_PLAYER_EXPERT;
+			options.aiPlayerType = pong::AiPlayerType::AI_PLAYER_EXPERT;
 		}
 		else if (cmd == "impossible") {
-			type = pong::AiPlayerType::AI_PLAYER_IMPOSSIBLE;
+			options.aiPlayerType = pong::AiPlayerType::AI_PLAYER_IMPOSSIBLE;
+		}
+		else if (cmd == "--push-constants") {
+			options.renderPath = pong::RenderPath::RENDER_PATH_PUSH_CONSTANT;
+		}
+		else if (cmd == "--parallel") {
+			options.renderPath = pong::RenderPath::RENDER_PATH_PARALLEL;
+		}
+		else if (cmd == "--quads" && i + 1 < argc) {
+			options.benchmarkQuads = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--headless") {
+			options.headless = true;
+		}
+		else if (cmd == "--frames-in-flight" && i + 1 < argc) {
+			options.framesInFlight = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--present" && i + 1 < argc) {
+			std::string mode(argv[++i]);
+
+			if (mode == "fifo") {
+				options.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+			}
+			else if (mode == "fifo-relaxed") {
+				options.presentMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+			}
+			else if (mode == "mailbox") {
+				options.presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+			}
+			else if (mode == "immediate") {
+				options.presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+			}
+		}
+		else if (cmd == "--tick-rate" && i + 1 < argc) {
+			options.tickRate = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--fps" && i + 1 < argc) {
+			options.targetFps = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--frames" && i + 1 < argc) {
+			options.frames = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--record" && i + 1 < argc) {
+			options.recordPath = argv[++i];
+		}
+		else if (cmd == "--replay" && i + 1 < argc) {
+			options.replayPath = argv[++i];
+		}
+		else if (cmd == "--replay-speed" && i + 1 < argc) {
+			options.replaySpeed = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if ((cmd == "--net-host" || cmd == "--net-join") && i + 2 < argc) {
+			options.netPlay = true;
+			options.netHost = (cmd == "--net-host");
+			options.netPort = (uint16_t)std::stoul(argv[++i]);
+			options.netPeer = argv[++i];
+		}
+		else if (cmd == "--net-delay" && i + 1 < argc) {
+			options.netDelay = std::stoul(argv[++i]);
 		}
 	}
 
 	app::Config config;
-	pong::setup(&config, type);
+	pong::setup(&config, options);
 
 	app::init(&config);
 	app::update();
@@ -0,0 +1,576 @@
+#include "net.h"
+#include "replay.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+
+namespace net {
+
+	// Ticks of input kept for both peers, far more than maxRollback, the
+	// input delay and one packet's inputs together.
+	const uint32_t inputHistory = 512;
+	const uint32_t maxInputDelay = 30;
+	const uint32_t maxRollbackLimit = 120;
+
+	// Unacknowledged inputs resent in every packet, so a lost packet costs
+	// nothing as long as a later one gets through.
+	const uint32_t maxPacketInputs = 64;
+
+	const uint64_t checkpointInterval = 60;
+	const uint32_t checkpointCount = 8;
+
+	const uint64_t noTick = UINT64_MAX;
+
+	// Packet
+	// magic 'P' 'N', version, input count, then little endian u32s: seed,
+	// sender tick, latest remote tick seen, ack, first input tick,
+	// checkpoint tick and hash, and one byte per input.
+	const uint8_t packetVersion = 1;
+	const size_t packetHeaderSize = 32;
+
+	void startMatch(Session& s, uint32_t seed);
+	uint32_t stepTick(Session& s, float delta);
+	uint32_t getRemoteInput(Session& s, uint64_t tick);
+	void rollback(Session& s, float delta);
+	void updateCheckpoints(Session& s);
+	void receivePacket(Session& s, const uint8_t* data, size_t size);
+	void sendInputs(Session& s);
+	void queuePacket(Session& s, std::vector<uint8_t>& data);
+
+	void writeU32(std::vector<uint8_t>& out, uint32_t value);
+	uint32_t readU32(const uint8_t* data);
+
+	bool parseAddress(const std::string& text, Address& address) {
+		size_t colon = text.rfind(':');
+
+		if (colon == std::string::npos) {
+			return false;
+		}
+
+		std::string host = text.substr(0, colon);
+
+		if (host == "localhost") {
+			host = "127.0.0.1";
+		}
+
+		in_addr addr;
+
+		if (inet_pton(AF_INET, host.c_str(), &addr) != 1) {
+			return false;
+		}
+
+		address.ip = ntohl(addr.s_addr);
+		address.port = (uint16_t)std::stoul(text.substr(colon + 1));
+
+		return true;
+	}
+
+	void openSocket(Socket& socket, uint16_t port) {
+#ifdef _WIN32
+		static bool started = false;
+
+		if (!started) {
+			WSADATA data;
+
+			if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+				throw std::runtime_error("failed to start winsock");
+			}
+
+			started = true;
+		}
+
+		SOCKET handle = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+		if (handle == INVALID_SOCKET) {
+			throw std::runtime_error("failed to create socket");
+		}
+
+		u_long nonBlocking = 1;
+		ioctlsocket(handle, FIONBIO, &nonBlocking);
+#else
+		int handle = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+		if (handle < 0) {
+			throw std::runtime_error("failed to create socket");
+		}
+
+		fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+		socket.handle = (intptr_t)handle;
+
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_ANY);
+		addr.sin_port = htons(port);
+
+		if (bind(handle, (sockaddr*)&addr, sizeof(addr)) != 0) {
+			closeSocket(socket);
+			throw std::runtime_error("failed to bind port " + std::to_string(port));
+		}
+
+		std::cout << "Success: Open UDP Socket (port " << port << ")" << std::endl;
+	}
+
+	void closeSocket(Socket& socket) {
+		if (socket.handle == -1) {
+			return;
+		}
+
+#ifdef _WIN32
+		closesocket((SOCKET)socket.handle);
+#else
+		close((int)socket.handle);
+#endif
+
+		socket.handle = -1;
+	}
+
+	void sendTo(Socket& socket, const Address& address, const uint8_t* data, size_t size) {
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(address.ip);
+		addr.sin_port = htons(address.port);
+
+		// A full send buffer or an unreachable peer is just another lost
+		// packet, the inputs go out again with the next one.
+#ifdef _WIN32
+		sendto((SOCKET)socket.handle, (const char*)data, (int)size, 0, (sockaddr*)&addr, sizeof(addr));
+#else
+		sendto((int)socket.handle, data, size, 0, (sockaddr*)&addr, sizeof(addr));
+#endif
+	}
+
+	size_t receive(Socket& socket, uint8_t* data, size_t size) {
+		while (true) {
+#ifdef _WIN32
+			int read = recvfrom((SOCKET)socket.handle, (char*)data, (int)size, 0, nullptr, nullptr);
+
+			// Windows reports an earlier send that bounced as a failed read
+			if (read < 0 && WSAGetLastError() == WSAECONNRESET) {
+				continue;
+			}
+#else
+			ssize_t read = recvfrom((int)socket.handle, data, size, 0, nullptr, nullptr);
+
+			if (read < 0 && errno == ECONNREFUSED) {
+				continue;
+			}
+#endif
+
+			return (read > 0) ? (size_t)read : 0;
+		}
+	}
+
+	void initSession(Session& s, const SessionConfig& config) {
+		s.config = config;
+		s.config.inputDelay = std::min(config.inputDelay, maxInputDelay);
+		s.config.maxRollback = std::clamp(config.maxRollback, 1u, maxRollbackLimit);
+
+		openSocket(s.socket, config.localPort);
+
+		s.outgoing.clear();
+		s.linkRng = sim::makeRng(config.localPort);
+
+		s.localInputs.assign(inputHistory, sim::Input::INPUT_NONE);
+		s.remoteInputs.assign(inputHistory, sim::Input::INPUT_NONE);
+		s.remoteTicks.assign(inputHistory, noTick);
+		s.remoteUsed.assign(inputHistory, sim::Input::INPUT_NONE);
+
+		// The first inputDelay ticks have no input from either peer
+		s.localEnd = s.config.inputDelay;
+		s.remoteEnd = s.config.inputDelay;
+		s.remoteAcked = 0;
+		s.remoteTick = 0;
+		s.remoteSeenTick = 0;
+		s.rollbackFrom = noTick;
+		s.lastSkip = 0;
+
+		for (uint64_t t = 0; t < s.config.inputDelay; t++) {
+			s.remoteTicks[t] = t;
+		}
+
+		s.checkpoints.assign(checkpointCount, Checkpoint());
+		s.nextCheckpoint = checkpointInterval;
+		s.checkedTick = 0;
+
+		s.stats = SessionStats();
+
+		// A rollback reaches back at most maxRollback ticks, checkpoints a
+		// few ticks more.
+		sim::initSnapshotRing(s.snapshots, s.config.maxRollback * 2 + 2);
+
+		s.started = false;
+
+		if (s.config.left) {
+			startMatch(s, s.config.seed);
+		}
+	}
+
+	void releaseSession(Session& s) {
+		closeSocket(s.socket);
+		s.outgoing.clear();
+	}
+
+	bool advanceSession(Session& s, uint32_t input, float delta, uint32_t& events) {
+		events = sim::Event::EVENT_NONE;
+
+		pollSession(s);
+
+		if (!s.started) {
+			return false;
+		}
+
+		rollback(s, delta);
+
+		bool stepped = false;
+		sim::Match& m = s.match;
+
+		// How far each peer is ahead of the other as it last saw it. If this
+		// one is clearly further ahead it sits a tick out now and then, or
+		// it would keep guessing and rolling back while the other waits.
+		int64_t localAdvantage = (int64_t)m.tick - (int64_t)s.remoteTick;
+		int64_t remoteAdvantage = (int64_t)s.remoteTick - (int64_t)s.remoteSeenTick;
+
+		if (m.tick >= s.remoteEnd + s.config.maxRollback) {
+			s.stats.stalls++;
+		}
+		else if ((localAdvantage - remoteAdvantage) / 2 >= 1 && m.tick >= s.lastSkip + 8) {
+			s.lastSkip = m.tick;
+			s.stats.skips++;
+		}
+		else {
+			s.localInputs[(m.tick + s.config.inputDelay) % inputHistory] = input;
+			s.localEnd = m.tick + s.config.inputDelay + 1;
+
+			events = stepTick(s, delta);
+			stepped = true;
+
+			s.stats.ticks++;
+		}
+
+		updateCheckpoints(s);
+		sendInputs(s);
+
+		return stepped;
+	}
+
+	void pollSession(Session& s) {
+		uint8_t data[1500];
+		size_t size;
+
+		while ((size = receive(s.socket, data, sizeof(data))) > 0) {
+			receivePacket(s, data, size);
+		}
+
+		auto now = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < s.outgoing.size();) {
+			if (s.outgoing[i].due <= now) {
+				sendTo(s.socket, s.config.remote, s.outgoing[i].data.data(), s.outgoing[i].data.size());
+
+				s.outgoing[i] = std::move(s.outgoing.back());
+				s.outgoing.pop_back();
+			}
+			else {
+				i++;
+			}
+		}
+	}
+
+	void startMatch(Session& s, uint32_t seed) {
+		s.config.seed = seed;
+
+		sim::initMatch(s.match, s.config.arena, sim::AiPlayerType::AI_PLAYER_EASY, seed);
+		s.match.aiPlayerHuman = true;
+
+		s.started = true;
+
+		std::cout << "Success: Start Net Match (seed " << seed << ", " << (s.config.left ? "left" : "right") << ")" << std::endl;
+	}
+
+	uint32_t stepTick(Session& s, float delta) {
+		sim::Match& m = s.match;
+		uint32_t slot = m.tick % inputHistory;
+
+		sim::pushSnapshot(s.snapshots, m);
+
+		uint32_t local = s.localInputs[slot];
+		uint32_t remote = getRemoteInput(s, m.tick);
+
+		s.remoteUsed[slot] = remote;
+
+		if (s.config.left) {
+			return sim::step(m, local, remote, delta);
+		}
+		else {
+			return sim::step(m, remote, local, delta);
+		}
+	}
+
+	// The real input if it arrived, otherwise the guess that the other
+	// player still holds what they held last.
+	uint32_t getRemoteInput(Session& s, uint64_t tick) {
+		uint32_t slot = tick % inputHistory;
+
+		if (s.remoteTicks[slot] == tick) {
+			return s.remoteInputs[slot];
+		}
+
+		return s.remoteInputs[(s.remoteEnd - 1) % inputHistory];
+	}
+
+	void rollback(Session& s, float delta) {
+		sim::Match& m = s.match;
+
+		if (s.rollbackFrom >= m.tick) {
+			s.rollbackFrom = noTick;
+			return;
+		}
+
+		uint64_t end = m.tick;
+		sim::Snapshot guessed;
+		sim::saveSnapshot(m, guessed);
+
+		if (!sim::rewindSnapshot(s.snapshots, m, s.rollbackFrom)) {
+			throw std::runtime_error("rollback past the snapshot ring");
+		}
+
+		// Events were already played the first time through
+		while (m.tick < end) {
+			stepTick(s, delta);
+		}
+
+		s.stats.rollbacks++;
+		s.stats.resimulatedTicks += end - s.rollbackFrom;
+
+		double correction =
+			glm::length(m.ball.position - guessed.ball.position) +
+			std::abs(m.player.position.y - guessed.player.position.y) +
+			std::abs(m.aiPlayer.position.y - guessed.aiPlayer.position.y);
+
+		s.stats.correction += correction;
+		s.stats.maxCorrection = std::max(s.stats.maxCorrection, correction);
+
+		s.rollbackFrom = noTick;
+	}
+
+	// Once both peers have every input before a checkpoint tick, the state
+	// at it is final and has to be the same for both.
+	void updateCheckpoints(Session& s) {
+		sim::Match& m = s.match;
+		uint64_t confirmed = std::min(std::min(s.remoteEnd, s.localEnd), m.tick);
+
+		while (s.nextCheckpoint <= confirmed) {
+			Checkpoint& c = s.checkpoints[(s.nextCheckpoint / checkpointInterval) % checkpointCount];
+			c.tick = s.nextCheckpoint;
+
+			if (c.tick == m.tick) {
+				c.hash = replay::hashMatch(m);
+			}
+			else {
+				sim::Match past = m;
+
+				if (!sim::rewindSnapshot(s.snapshots, past, c.tick)) {
+					throw std::runtime_error("checkpoint past the snapshot ring");
+				}
+
+				c.hash = replay::hashMatch(past);
+			}
+
+			s.nextCheckpoint += checkpointInterval;
+		}
+	}
+
+	void receivePacket(Session& s, const uint8_t* data, size_t size) {
+		if (size < packetHeaderSize || data[0] != 'P' || data[1] != 'N' || data[2] != packetVersion) {
+			return;
+		}
+
+		uint32_t count = data[3];
+
+		if (size < packetHeaderSize + count) {
+			return;
+		}
+
+		uint32_t seed = readU32(data + 4);
+		uint64_t senderTick = readU32(data + 8);
+		uint64_t seenTick = readU32(data + 12);
+		uint64_t ack = readU32(data + 16);
+		uint64_t first = readU32(data + 20);
+		uint64_t checkTick = readU32(data + 24);
+		uint32_t checkHash = readU32(data + 28);
+
+		if (!s.started) {
+			if (s.config.left) {
+				return;
+			}
+
+			startMatch(s, seed);
+		}
+
+		// From an earlier match
+		if (seed != s.config.seed) {
+			return;
+		}
+
+		s.stats.packetsReceived++;
+
+		if (senderTick >= s.remoteTick) {
+			s.remoteTick = senderTick;
+			s.remoteSeenTick = seenTick;
+		}
+
+		s.remoteAcked = std::max(s.remoteAcked, std::min(ack, s.localEnd));
+
+		uint64_t tick = s.match.tick;
+
+		for (uint32_t i = 0; i < count; i++) {
+			uint64_t t = first + i;
+
+			if (t < s.remoteEnd) {
+				continue;
+			}
+
+			// The other peer can't get this far ahead, the packet is broken
+			if (t >= tick + inputHistory / 2) {
+				break;
+			}
+
+			uint32_t slot = t % inputHistory;
+
+			if (s.remoteTicks[slot] == t) {
+				continue;
+			}
+
+			uint32_t input = data[packetHeaderSize + i];
+
+			s.remoteInputs[slot] = input;
+			s.remoteTicks[slot] = t;
+			s.stats.remoteInputs++;
+
+			if (t < tick) {
+				s.stats.predictions++;
+
+				if (s.remoteUsed[slot] != input) {
+					s.stats.mispredictions++;
+					s.rollbackFrom = std::min(s.rollbackFrom, t);
+				}
+			}
+		}
+
+		while (s.remoteTicks[s.remoteEnd % inputHistory] == s.remoteEnd) {
+			s.remoteEnd++;
+		}
+
+		if (checkTick > s.checkedTick) {
+			const Checkpoint& c = s.checkpoints[(checkTick / checkpointInterval) % checkpointCount];
+
+			if (c.tick == checkTick) {
+				s.checkedTick = checkTick;
+
+				if (c.hash == checkHash) {
+					s.stats.checks++;
+				}
+				else {
+					if (s.stats.desyncs == 0) {
+						std::cout << "Net: desync at tick " << checkTick << std::endl;
+					}
+
+					s.stats.desyncs++;
+				}
+			}
+		}
+	}
+
+	void sendInputs(Session& s) {
+		if (!s.started) {
+			return;
+		}
+
+		uint64_t first = s.remoteAcked;
+		uint32_t count = (uint32_t)std::min<uint64_t>(s.localEnd - first, maxPacketInputs);
+
+		// The newest checkpoint this peer has
+		const Checkpoint& check = s.checkpoints[((s.nextCheckpoint - checkpointInterval) / checkpointInterval) % checkpointCount];
+
+		std::vector<uint8_t> data;
+		data.reserve(packetHeaderSize + count);
+
+		data.push_back('P');
+		data.push_back('N');
+		data.push_back(packetVersion);
+		data.push_back((uint8_t)count);
+		writeU32(data, s.config.seed);
+		writeU32(data, (uint32_t)s.match.tick);
+		writeU32(data, (uint32_t)s.remoteTick);
+		writeU32(data, (uint32_t)s.remoteEnd);
+		writeU32(data, (uint32_t)first);
+		writeU32(data, (uint32_t)check.tick);
+		writeU32(data, check.hash);
+
+		for (uint32_t i = 0; i < count; i++) {
+			data.push_back((uint8_t)s.localInputs[(first + i) % inputHistory]);
+		}
+
+		queuePacket(s, data);
+	}
+
+	void queuePacket(Session& s, std::vector<uint8_t>& data) {
+		const LinkConditions& link = s.config.link;
+
+		s.stats.packetsSent++;
+
+		if (link.loss > 0.0f && (s.linkRng() >> 8) * (1.0f / 16777216.0f) < link.loss) {
+			s.stats.packetsDropped++;
+			return;
+		}
+
+		float delay = link.latency;
+
+		if (link.jitter > 0.0f) {
+			delay += ((s.linkRng() >> 8) * (2.0f / 16777216.0f) - 1.0f) * link.jitter;
+		}
+
+		if (delay <= 0.0f) {
+			sendTo(s.socket, s.config.remote, data.data(), data.size());
+			return;
+		}
+
+		DelayedPacket packet;
+		packet.due = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(delay));
+		packet.data = std::move(data);
+
+		s.outgoing.push_back(std::move(packet));
+	}
+
+	void writeU32(std::vector<uint8_t>& out, uint32_t value) {
+		for (uint32_t i = 0; i < 4; i++) {
+			out.push_back((uint8_t)(value >> (i * 8)));
+		}
+	}
+
+	uint32_t readU32(const uint8_t* data) {
+		return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+	}
+}
\ No newline at end of file
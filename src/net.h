@@ -0,0 +1,159 @@
+#pragma once
+
+
+// Two player matches over UDP, one peer on each paddle. Each peer steps
+// its own copy of the match every tick with its own input and a guess of
+// the other's, and once the other's real input arrives and differs it
+// rewinds to that tick and steps forward again. Local input is applied a
+// few ticks late (the input delay) so most of the time it reaches the
+// other peer before that peer needs it and nothing has to be redone.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <glm/glm.hpp>
+
+#include "sim.h"
+
+namespace net {
+	// IPv4 address and port, in host byte order
+	struct Address {
+		uint32_t ip = 0;
+		uint16_t port = 0;
+	};
+
+	// Non blocking UDP socket, the handle is a SOCKET on Windows and a
+	// file descriptor elsewhere.
+	struct Socket {
+		intptr_t handle = -1;
+	};
+
+	// Applied to every packet sent, for testing bad networks on loopback
+	struct LinkConditions {
+		// Seconds, every packet gets latency plus up to jitter either way,
+		// so packets can also arrive out of order.
+		float latency = 0.0f;
+		float jitter = 0.0f;
+		// 0 to 1, chance a packet is dropped
+		float loss = 0.0f;
+	};
+
+	struct DelayedPacket {
+		std::chrono::steady_clock::time_point due;
+		std::vector<uint8_t> data;
+	};
+
+	struct SessionConfig {
+		uint16_t localPort = 0;
+		Address remote;
+		// The left peer picks the seed and plays player, the right one
+		// plays aiPlayer.
+		bool left = true;
+		uint32_t seed = 1;
+		glm::vec2 arena = glm::vec2(640.0f, 480.0f);
+		// Ticks local input waits before it is applied
+		uint32_t inputDelay = 2;
+		// The furthest back a peer rewinds, it waits for the other rather
+		// than guess further ahead.
+		uint32_t maxRollback = 32;
+		LinkConditions link;
+	};
+
+	struct SessionStats {
+		uint64_t ticks = 0;
+		uint64_t rollbacks = 0;
+		uint64_t resimulatedTicks = 0;
+		uint64_t remoteInputs = 0;
+		// Remote inputs that arrived after their tick was stepped with a
+		// guess, and those of them the guess got wrong.
+		uint64_t predictions = 0;
+		uint64_t mispredictions = 0;
+		// Pixels the paddles and ball jumped when a rollback corrected them
+		double correction = 0.0;
+		double maxCorrection = 0.0;
+		// Ticks not stepped, waiting on the other peer or letting it catch up
+		uint64_t stalls = 0;
+		uint64_t skips = 0;
+		uint64_t packetsSent = 0;
+		uint64_t packetsDropped = 0;
+		uint64_t packetsReceived = 0;
+		// Checkpoints the other peer reached the same state on, and didn't,
+		// each counted once
+		uint64_t checks = 0;
+		uint64_t desyncs = 0;
+	};
+
+	// Hash of the match at a tick both peers have every input before
+	struct Checkpoint {
+		uint64_t tick = 0;
+		uint32_t hash = 0;
+	};
+
+	struct Session {
+		SessionConfig config;
+		Socket socket;
+		// Link conditions are applied on the way out
+		std::vector<DelayedPacket> outgoing;
+		sim::Rng linkRng;
+
+		// The right peer waits for the seed in the left one's packets
+		bool started = false;
+
+		sim::Match match;
+		sim::SnapshotRing snapshots;
+
+		// Rings of inputHistory ticks, tick t at t % inputHistory
+		std::vector<uint32_t> localInputs;
+		std::vector<uint32_t> remoteInputs;
+		// Tick each remoteInputs slot holds, noTick when empty
+		std::vector<uint64_t> remoteTicks;
+		// The remote input each tick was stepped with, real or guessed
+		std::vector<uint32_t> remoteUsed;
+
+		// Local inputs exist for every tick below this
+		uint64_t localEnd = 0;
+		// Remote inputs arrived for every tick below this
+		uint64_t remoteEnd = 0;
+		// The remote peer has all local inputs below this
+		uint64_t remoteAcked = 0;
+		// Latest tick the remote peer reported being at, and the latest of
+		// ours it had seen then.
+		uint64_t remoteTick = 0;
+		uint64_t remoteSeenTick = 0;
+
+		// Earliest tick stepped with a wrong guess since the last rollback
+		uint64_t rollbackFrom = UINT64_MAX;
+		uint64_t lastSkip = 0;
+
+		// The last few checkpoints, sent to the other peer to compare
+		std::vector<Checkpoint> checkpoints;
+		uint64_t nextCheckpoint = 0;
+		// Newest checkpoint of ours compared, the other peer sends each one
+		// in many packets and it should only be counted once
+		uint64_t checkedTick = 0;
+
+		SessionStats stats;
+	};
+
+	// "host:port" with host an IPv4 address or localhost
+	bool parseAddress(const std::string& text, Address& address);
+
+	void openSocket(Socket& socket, uint16_t port);
+	void closeSocket(Socket& socket);
+	void sendTo(Socket& socket, const Address& address, const uint8_t* data, size_t size);
+	// Size of the packet read into data, 0 when none is waiting
+	size_t receive(Socket& socket, uint8_t* data, size_t size);
+
+	// Throws if the socket can't be opened
+	void initSession(Session& s, const SessionConfig& config);
+	void releaseSession(Session& s);
+
+	// Reads what arrived, rolls back if a guess was wrong, then steps a tick
+	// with input from this peer if the other one isn't too far behind.
+	// Returns whether it stepped, with the tick's events in events.
+	bool advanceSession(Session& s, uint32_t input, float delta, uint32_t& events);
+
+	// Reads what arrived and sends what is due without stepping
+	void pollSession(Session& s);
+}
\ No newline at end of file
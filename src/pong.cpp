@@ -11,113 +11,177 @@ namespace pong {
 		glm::mat4 model;
 	};
 
-	struct Paddle {
+	// What every paddle and ball is drawn from. The push constant path
+	// pushes it as is, the instanced path expands it to a UniformModel.
+	struct Quad {
 		glm::vec2 position;
 		glm::vec2 size;
-		glm::vec2 velocity;
-		float speed = 32.0f;
-	};
-
-	struct Ball {
-		glm::vec2 position;
-		glm::vec2 size;
-		glm::vec2 velocity;
-		glm::vec2 speed;
+		glm::vec4 color;
 	};
 
 	vk::Vulkan vulkan;
 	// Buffer Section
 	std::vector<glm::vec3> verticesList;
-	VkBuffer stageVerticesBuffer;
 	VkBuffer verticesBuffer;
 	std::vector<std::uint32_t> indexList;
-	VkBuffer stageIndexBuffer;
 	VkBuffer indexBuffer;
-	VkDeviceSize verticesOffset;
-	VkDeviceSize verticesSize;
-	VkDeviceSize indexOffset;
-	VkDeviceSize indexSize;
-	VkDeviceSize stageMemory;
-	VkDeviceMemory bufferMemory;
+	vk::MemoryAllocation verticesMemory;
+	vk::MemoryAllocation indexMemory;
 
 	// Uniforms
 	// Uniform Camera
 	UniformCamera camera;
-	VkBuffer stageCameraBuffer;
-	VkBuffer cameraBuffer;
-	VkDeviceMemory stageCameraMemory;
-	VkDeviceMemory cameraMemory;
-
-	// Uniform Model
-	std::vector<UniformModel> models;
-	std::vector<VkBuffer> stageModelsBuffer;
-	std::vector<VkBuffer> modelsBuffer;
-	std::vector<VkDeviceSize> modelOffsets;
-	std::vector<VkDeviceSize> modelSize;
-	VkDeviceMemory stageModelMemory;
-	VkDeviceMemory modelMemory;
 
-	// Graphics Pipeline
-	const uint32_t numUniformModel = 3;
+	// Instances
+	// Every paddle and ball is one instance of the quad. The transforms
+	// are packed into a single storage buffer that main.vert indexes with
+	// gl_InstanceIndex, so the whole scene is one vkCmdDrawIndexed.
+	uint32_t maxInstances = 4096;
+	std::vector<Quad> quads;
+	VkDeviceSize instanceBufferSize;
+
+	// Frame Ring
+	// The camera and instances for every frame live in one persistently
+	// mapped, host coherent buffer. There is one slice per swapchain image,
+	// as the command buffers are recorded per image, picked with dynamic
+	// offsets. beginFrame waits on the image's fence in imageInFlight, so
+	// a frame's uniforms are then written with a plain memcpy.
+	VkBuffer ringBuffer;
+	vk::MemoryAllocation ringMemory;
+	uint8_t* ringData = nullptr;
+	VkDeviceSize ringSliceSize;
+	VkDeviceSize ringInstanceOffset;
+	uint32_t ringSliceCount;
 
+	// Graphics Pipeline
 	VkDescriptorSetLayout cameraSetLayout;
-	VkDescriptorSetLayout modelSetLayout;
+	VkDescriptorSetLayout instanceSetLayout;
 	VkPipelineLayout pipelineLayout;
 	VkPipeline graphicsPipeline;
 
+	// Push Constant Pipeline
+	// Camera set only, each quad is pushed right before its draw so its
+	// command buffer has to be recorded every frame.
+	VkPipelineLayout pushPipelineLayout;
+	VkPipeline pushPipeline;
+
+	RenderPath renderPath;
+
+	// Parallel Recording
+	// The quads are split into chunks of recordChunkSize, each recorded
+	// into a secondary command buffer by whichever thread picks it up and
+	// executed from the primary in chunk order. Command pools are per
+	// thread and per swapchain image, so a thread only ever records from
+	// its own pool and a pool is reset once its image's fence signals.
+	// Made the first time this path records, the other paths never start
+	// the threads.
+	struct RecordThread {
+		std::vector<VkCommandPool> pools;
+		std::vector<std::vector<VkCommandBuffer>> buffers;
+		std::vector<uint32_t> used;
+	};
+
+	const uint32_t recordChunkSize = 1024;
+	util::ThreadPool recordPool;
+	std::vector<RecordThread> recordThreads;
+	std::vector<VkCommandBuffer> chunkBuffers;
+
+	// Static quads added behind the game with --quads, to load the renderer
+	uint32_t benchmarkQuads = 0;
+
 	//VkDescriptorPool descriptorPool;
 	VkDescriptorPool cameraSetPool;
 	VkDescriptorSet cameraSet;
-	VkDescriptorPool modelSetPool;
-	std::vector<VkDescriptorSet> modelSet;
+	VkDescriptorPool instanceSetPool;
+	VkDescriptorSet instanceSet;
 
 	std::vector<VkCommandBuffer> commandBuffers;
+	// What each image's command buffer was last recorded for, the instanced
+	// one only has to be recorded again when either of these change.
+	std::vector<RenderPath> recordedPath;
+	std::vector<uint32_t> recordedQuads;
+
+	// CPU time render() spends recording, submitting and presenting,
+	// averaged over a couple of seconds for comparing the render paths.
+	// The wait in beginFrame and the rest of the frame aren't counted.
+	double renderTime = 0.0;
+	uint32_t renderFrames = 0;
+
+	// GPU Timestamps
+	// Written by every command buffer, the whole render pass and just the
+	// draws of the quads within it.
+	enum GpuTimestamp {
+		GPU_PASS_BEGIN = 0,
+		GPU_DRAW_BEGIN,
+		GPU_DRAW_END,
+		GPU_PASS_END,
+		GPU_TIMESTAMP_COUNT
+	};
+
+	std::vector<double> gpuTimes;
+	double gpuPassTime = 0.0;
+	double gpuDrawTime = 0.0;
+	uint32_t gpuFrames = 0;
+	std::chrono::steady_clock::time_point renderReport;
+
+	// Reused every frame so building a submission never allocates
+	std::vector<VkSemaphore> waitSemaphores;
+	std::vector<VkPipelineStageFlags> waitStages;
 
-	uint32_t currentFrame = 0;
 	uint32_t nextImage = 0;
 
-	Paddle player;
-	Paddle aiPlayer;
-	Ball ball;
+	sim::Match match;
 
-	std::mt19937 mrand;
+	// State as of the tick before, render() draws in between the two
+	sim::Paddle prevPlayer;
+	sim::Paddle prevAiPlayer;
+	sim::Ball prevBall;
 
 	AiPlayerType aiPlayerType;
 
+	// Replay
+	std::string recordPath;
+	std::string replayPath;
+	uint32_t replaySpeed = 1;
+	float tickDelta = 0.0f;
+	replay::Recorder recorder;
+	replay::Player replayPlayer;
+	bool replaying = false;
+
+	// Net play, match is a copy of session.match after every tick
+	bool netPlay = false;
+	net::SessionConfig netConfig;
+	net::Session session;
+
 	void initBuffers();
+	void initFrameRing();
+	void releaseFrameRing();
 	void initPipelineLayout();
 	void initGraphicsPipeline();
 	void initDescriptorPool();
 	void initDescriptorSets();
 	void initCommandBuffer();
-
-	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-
-	void toRect(util::Rect& r, Paddle& pad);
-	void toRect(util::Rect& r, Ball& ball);
-
-	void updatePaddlePlayer(Paddle& pad, float delta);
-
-	void updatePaddleImpossible(Paddle& pad, float delta);
-	void updatePaddleExpert(Paddle& pad, float delta);
-	void updatePaddleHard(Paddle& pad, float delta);
-	void updatePaddleNormal(Paddle& pad, float delta);
-	void updatePaddleEasy(Paddle& pad, float delta);
-
-	std::map<AiPlayerType, std::function<void(Paddle&, float)>> aiUpdates = {
-		{AiPlayerType::AI_PLAYER_EASY, updatePaddleEasy},
-		{AiPlayerType::AI_PLAYER_NORMAL, updatePaddleNormal},
-		{AiPlayerType::AI_PLAYER_HARD, updatePaddleHard},
-		{AiPlayerType::AI_PLAYER_EXPERT, updatePaddleExpert},
-		{AiPlayerType::AI_PLAYER_IMPOSSIBLE, updatePaddleImpossible}
-	};
-
-	void resetBall(Ball& b);
-	void updateBall(Ball& b, float delta);
+	VkPipeline createGraphicsPipeline(std::string vertPath, std::string fragPath, VkPipelineLayout layout);
+	void recordInstancedCommandBuffer(uint32_t image);
+	void recordPushCommandBuffer(uint32_t image);
+	void recordParallelCommandBuffer(uint32_t image);
+	void beginRenderPass(VkCommandBuffer cb, uint32_t image, VkSubpassContents contents);
+	void setViewport(VkCommandBuffer cb);
+	void recreateSwapchain();
+	void waitFrame();
+	void recordQuads(VkCommandBuffer cb, uint32_t image, uint32_t first, uint32_t count);
+	void initRecordThreads();
+	void releaseRecordThreads();
+	VkCommandBuffer getRecordBuffer(uint32_t thread, uint32_t image);
+	void initBenchmarkQuads();
+
+	void toQuad(Quad& q, const sim::Paddle& prev, const sim::Paddle& curr, float alpha);
+	void toQuad(Quad& q, const sim::Ball& prev, const sim::Ball& curr, float alpha);
+
+	void playEvents(uint32_t events);
+	void stepReplay();
 
 	void init() {
-		mrand = std::mt19937(std::chrono::steady_clock::now().time_since_epoch().count());
-
 		input::init();
 
 		input::createInputMapping("move-up", input::createInputMapKey(input::Keys::KEY_UP));
@@ -136,6 +200,8 @@ namespace pong {
 		// Buffers
 		initBuffers();
 
+		vk::reportMemory(vulkan);
+
 		// Graphics Pipeline
 		initPipelineLayout();
 
@@ -145,105 +211,310 @@ namespace pong {
 
 		initDescriptorSets();
 
+		// Before any command buffer is recorded, so they all write timestamps
+		vk::initTimestamps(vulkan, GpuTimestamp::GPU_TIMESTAMP_COUNT);
+
 		initCommandBuffer();
 
 		camera.proj = glm::ortho(0.0f, (float)vulkan.swapchainExtent.width, 0.0f, (float)vulkan.swapchainExtent.height);
 		camera.view = glm::mat4(1.0f);
 
 
-		player.size = glm::vec2(8.0f, 64.0f);
-		player.position = glm::vec2(4.0f, (vulkan.swapchainExtent.height * 0.5f - player.size.y * 0.5f));
-		player.velocity = glm::vec2(0.0f);
-		player.speed = 128.0f;
+		uint32_t events = sim::Event::EVENT_NONE;
+
+		if (netPlay) {
+			netConfig.seed = (uint32_t)std::chrono::steady_clock::now().time_since_epoch().count();
+			net::initSession(session, netConfig);
+			match = session.match;
+		}
+		else if (!replayPath.empty()) {
+			replay::openPlayer(replayPlayer, replayPath);
+			events = replay::initMatch(match, replayPlayer.header);
+			replaying = true;
+		}
+		else {
+			replay::Header header;
+			header.seed = (uint32_t)std::chrono::steady_clock::now().time_since_epoch().count();
+			header.aiPlayerType = aiPlayerType;
+			header.arena = glm::vec2(vulkan.swapchainExtent.width, vulkan.swapchainExtent.height);
+			header.delta = tickDelta;
+
+			events = replay::initMatch(match, header);
 
-		aiPlayer.size = glm::vec2(8.0f, 64.0f);
-		aiPlayer.position = glm::vec2(vulkan.swapchainExtent.width - aiPlayer.size.x - 4.0f, (vulkan.swapchainExtent.height * 0.5f - player.size.y * 0.5f));
-		aiPlayer.velocity = glm::vec2(0.0f);
-		aiPlayer.speed = 128.0f;
+			if (!recordPath.empty()) {
+				replay::openRecorder(recorder, recordPath, header);
+			}
+		}
 
-		ball.size = glm::vec2(16.0f);
-		resetBall(ball);
+		playEvents(events);
+
+		prevPlayer = match.player;
+		prevAiPlayer = match.aiPlayer;
+		prevBall = match.ball;
+
+		initBenchmarkQuads();
 	}
 
 	void doEvent(SDL_Event& e) {
 		input::doEvent(e);
+
+		if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+			vulkan.swapchainOutOfDate = true;
+		}
+
+		// Handled per event rather than per tick, a frame may run any
+		// number of ticks.
+		if (e.type == SDL_KEYDOWN && e.key.keysym.scancode == SDL_SCANCODE_F2 && !e.key.repeat) {
+			renderPath = (RenderPath)((renderPath + 1) % RenderPath::RENDER_PATH_COUNT);
+
+			renderTime = 0.0;
+			renderFrames = 0;
+		}
 	}
 
+	// Called once per tick with the fixed tick length
 	void update(float delta) {
-		updatePaddlePlayer(player, delta);
-		aiUpdates[aiPlayerType](aiPlayer, delta);
-		updateBall(ball, delta);
+		prevPlayer = match.player;
+		prevAiPlayer = match.aiPlayer;
+		prevBall = match.ball;
+
+		if (replaying) {
+			for (uint32_t i = 0; i < replaySpeed && replaying; i++) {
+				stepReplay();
+			}
+
+			return;
+		}
+
+		uint32_t input = sim::Input::INPUT_NONE;
+
+		if (input::isInputMapPress("move-up")) {
+			input = sim::Input::INPUT_UP;
+		}
+		else if (input::isInputMapPress("move-down")) {
+			input = sim::Input::INPUT_DOWN;
+		}
+
+		if (netPlay) {
+			uint32_t events;
+
+			if (!net::advanceSession(session, input, delta, events)) {
+				return;
+			}
+
+			match = session.match;
+
+			if (events & sim::Event::EVENT_SPAWN_BALL) {
+				prevBall = match.ball;
+			}
+
+			playEvents(events);
+
+			return;
+		}
+
+		if (recorder.file) {
+			replay::recordTick(recorder, input, match.arena, delta);
+		}
+
+		uint32_t events = sim::step(match, input, delta);
+
+		// Respawning is a jump, not something to interpolate across
+		if (events & sim::Event::EVENT_SPAWN_BALL) {
+			prevBall = match.ball;
+		}
+
+		playEvents(events);
 	}
 
-	void updateUniforms() {
+	// One tick from the log, once it runs out the player takes over
+	void stepReplay() {
+		uint32_t input;
+		float delta;
 
-		// Update Camera
-		void* data;
+		if (!replay::nextTick(replayPlayer, input, match.arena, delta)) {
+			if (!replayPlayer.hasHash) {
+				std::cout << "Replay: log cut short, playing on from tick " << match.tick << std::endl;
+			}
+			else if (replayPlayer.hash == replay::hashMatch(match)) {
+				std::cout << "Replay: ended where the recording did, tick " << match.tick << std::endl;
+			}
+			else {
+				std::cout << "Replay: desync, tick " << match.tick << " is not where the recording ended" << std::endl;
+			}
 
-		vkMapMemory(vulkan.device, stageCameraMemory, 0, sizeof(UniformCamera), 0, &data);
-		memcpy(data, &camera, sizeof(UniformCamera));
-		vkUnmapMemory(vulkan.device, stageCameraMemory);
+			replay::closePlayer(replayPlayer);
+			replaying = false;
+
+			return;
+		}
+
+		uint32_t events = sim::step(match, input, delta);
+
+		if (events & sim::Event::EVENT_SPAWN_BALL) {
+			prevBall = match.ball;
+		}
+
+		playEvents(events);
+	}
+
+	void playEvents(uint32_t events) {
+		if (events & (sim::Event::EVENT_WALL_HIT | sim::Event::EVENT_PADDLE_HIT)) {
+			audio::playSoundFX("ball-hit");
+		}
 
-		copyBuffer(stageCameraBuffer, cameraBuffer, sizeof(UniformCamera));
+		if (events & sim::Event::EVENT_SPAWN_BALL) {
+			audio::playSoundFX("spawn-ball");
+		}
+	}
+
+	void updateUniforms(uint32_t slice) {
+		uint8_t* data = ringData + slice * ringSliceSize;
 
-		// Update Models
-		for (size_t i = 0; i < models.size(); i++) {
-			vkMapMemory(vulkan.device, stageModelMemory, modelOffsets[i], modelSize[i], 0, &data);
-			memcpy(data, &models[i], modelSize[i]);
-			vkUnmapMemory(vulkan.device, stageModelMemory);
+		// Update Camera
+		memcpy(data, &camera, sizeof(UniformCamera));
 
-			copyBuffer(stageModelsBuffer[i], modelsBuffer[i], modelSize[i]);
+		// Update Instances
+		if (renderPath == RenderPath::RENDER_PATH_INSTANCED) {
+			UniformModel* instances = (UniformModel*)(data + ringInstanceOffset);
+
+			for (size_t i = 0; i < quads.size(); i++) {
+				instances[i].model =
+					glm::translate(glm::mat4(1.0f), glm::vec3(quads[i].position, 0.0f)) *
+					glm::scale(glm::mat4(1.0f), glm::vec3(quads[i].size, 0.0f));
+			}
 		}
 	}
 
 	void render() {
-		vkWaitForFences(vulkan.device, 1, &vulkan.inFlight[currentFrame], VK_TRUE, UINT64_MAX);
+		if (vulkan.swapchainOutOfDate) {
+			recreateSwapchain();
+
+			if (vulkan.swapchainOutOfDate) {
+				return;
+			}
+		}
+
+		if (!vk::beginFrame(vulkan)) {
+			return;
+		}
 
-		vkAcquireNextImageKHR(vulkan.device, vulkan.swapchain, UINT64_MAX, vulkan.submitCB[currentFrame], VK_NULL_HANDLE, &nextImage);
+		nextImage = vulkan.currentImage;
+
+		// The image's previous frame is done, so its queries are too
+		if (vk::readTimestamps(vulkan, nextImage, gpuTimes)) {
+			gpuPassTime += gpuTimes[GpuTimestamp::GPU_PASS_END];
+			gpuDrawTime += gpuTimes[GpuTimestamp::GPU_DRAW_END] - gpuTimes[GpuTimestamp::GPU_DRAW_BEGIN];
+			gpuFrames++;
+		}
 
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-		updateUniforms();
+		float alpha = app::getAlpha();
 
-		if (vulkan.imageInFlight[nextImage] != VK_NULL_HANDLE) {
-			vkWaitForFences(vulkan.device, 1, &vulkan.imageInFlight[nextImage], VK_TRUE, UINT64_MAX);
+		toQuad(quads[0], prevPlayer, match.player, alpha);
+		toQuad(quads[1], prevAiPlayer, match.aiPlayer, alpha);
+		toQuad(quads[2], prevBall, match.ball, alpha);
+
+		// The command buffer for this image reads the slice with the same
+		// index, and beginFrame has waited for the GPU to be done with it.
+		updateUniforms(nextImage);
+
+		if (renderPath == RenderPath::RENDER_PATH_PUSH_CONSTANT) {
+			recordPushCommandBuffer(nextImage);
+		}
+		else if (renderPath == RenderPath::RENDER_PATH_PARALLEL) {
+			recordParallelCommandBuffer(nextImage);
+		}
+		else if (recordedPath[nextImage] != renderPath || recordedQuads[nextImage] != quads.size()) {
+			recordInstancedCommandBuffer(nextImage);
 		}
 
-		vulkan.imageInFlight[nextImage] = vulkan.inFlight[nextImage];
+		waitSemaphores.clear();
+		waitStages.clear();
 
-		VkPipelineStageFlags waitStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		// Any upload still running on the transfer queue has to land before
+		// the vertex stages read what it wrote.
+		vk::takeUploadSemaphores(vulkan, waitSemaphores);
+		waitStages.resize(waitSemaphores.size(), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
 
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &vulkan.submitCB[currentFrame];
-		submitInfo.pWaitDstStageMask = &waitStages;
+		vk::endFrame(vulkan, commandBuffers[nextImage], waitSemaphores, waitStages);
 
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffers[nextImage];
-		
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = &vulkan.submitPresentQueue[currentFrame];
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+		renderTime += std::chrono::duration<double, std::milli>(end - start).count();
+		renderFrames++;
+
+		if (end - renderReport > std::chrono::seconds(2)) {
+			const char* names[] = { "instanced", "push constants", "parallel" };
 
-		vkResetFences(vulkan.device, 1, &vulkan.inFlight[currentFrame]);
+			std::cout << "Render (" << names[renderPath] << ", " << quads.size() << " quads, "
+				<< vulkan.framesInFlight << " frames in flight): "
+				<< renderTime / renderFrames << " ms cpu to record and submit";
+
+			if (gpuFrames > 0) {
+				std::cout << ", " << gpuPassTime / gpuFrames << " ms gpu pass"
+					<< ", " << gpuDrawTime / gpuFrames << " ms gpu draws";
+			}
 
-		if (vkQueueSubmit(vulkan.graphicsQueue, 1, &submitInfo, vulkan.inFlight[currentFrame]) != VK_SUCCESS) {
-			std::runtime_error("failed to submit draw command buffer!");
+			std::cout << std::endl;
+
+			renderTime = 0.0;
+			renderFrames = 0;
+			gpuPassTime = 0.0;
+			gpuDrawTime = 0.0;
+			gpuFrames = 0;
+			renderReport = end;
 		}
+	}
 
-		VkPresentInfoKHR presentInfo = {};
-		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	void waitFrame() {
+		vk::waitFrame(vulkan);
+	}
 
-		presentInfo.waitSemaphoreCount = 1;
-		presentInfo.pWaitSemaphores = &vulkan.submitPresentQueue[currentFrame];
+	void recreateSwapchain() {
+		size_t imageCount = vulkan.swapchainImages.size();
+		VkFormat format = vulkan.swapchainImageFormat;
 
-		presentInfo.swapchainCount = 1;
-		presentInfo.pSwapchains = &vulkan.swapchain;
+		if (!vk::recreateSwapchain(vulkan)) {
+			// Minimized, try again next frame
+			return;
+		}
 
-		presentInfo.pImageIndices = &nextImage;
+		vulkan.swapchainOutOfDate = false;
 
-		vkQueuePresentKHR(vulkan.presentQueue, &presentInfo);
+		// vk::recreateSwapchain made a new render pass for the new format
+		if (vulkan.swapchainImageFormat != format) {
+			vkDestroyPipeline(vulkan.device, pushPipeline, nullptr);
+			vkDestroyPipeline(vulkan.device, graphicsPipeline, nullptr);
+
+			initGraphicsPipeline();
+		}
+
+		// Every frame is done, so whatever is kept per image can go
+		if (vulkan.swapchainImages.size() != imageCount) {
+			releaseFrameRing();
+			initFrameRing();
+
+			// The sets point at the old ring
+			vkResetDescriptorPool(vulkan.device, cameraSetPool, 0);
+			vkResetDescriptorPool(vulkan.device, instanceSetPool, 0);
+			initDescriptorSets();
+
+			vkFreeCommandBuffers(vulkan.device, vulkan.commandPool, commandBuffers.size(), commandBuffers.data());
+			initCommandBuffer();
+
+			// Made again for the new count the next time they're used
+			releaseRecordThreads();
+		}
+
+		camera.proj = glm::ortho(0.0f, (float)vulkan.swapchainExtent.width, 0.0f, (float)vulkan.swapchainExtent.height);
+
+		match.arena = glm::vec2(vulkan.swapchainExtent.width, vulkan.swapchainExtent.height);
 
-		currentFrame = (currentFrame + 1) % vulkan.swapchainImages.size();
+		// The cached instanced command buffers point at the old framebuffers,
+		// render() records each again before it is next submitted.
+		std::fill(recordedPath.begin(), recordedPath.end(), RenderPath::RENDER_PATH_COUNT);
 	}
 
 	void postUpdate() {
@@ -251,89 +522,67 @@ namespace pong {
 	}
 
 	void release() {
-		vkWaitForFences(vulkan.device, 1, &vulkan.inFlight[currentFrame], VK_TRUE, UINT64_MAX);
-		if (vulkan.imageInFlight[nextImage] != VK_NULL_HANDLE) {
-			vkWaitForFences(vulkan.device, 1, &vulkan.imageInFlight[nextImage], VK_TRUE, UINT64_MAX);
+		replay::closeRecorder(recorder, match);
+		replay::closePlayer(replayPlayer);
+
+		if (netPlay) {
+			const net::SessionStats& stats = session.stats;
+
+			std::cout << "Net: " << stats.rollbacks << " rollbacks, " << stats.resimulatedTicks << " ticks resimulated, "
+				<< stats.mispredictions << " of " << stats.predictions << " guesses wrong, "
+				<< stats.desyncs << " desyncs" << std::endl;
+
+			net::releaseSession(session);
 		}
 
-		vulkan.imageInFlight[0] = VK_NULL_HANDLE;
-		vulkan.imageInFlight[1] = VK_NULL_HANDLE;
+		vk::waitUploads(vulkan);
+
+		vk::waitFrames(vulkan);
+
+		releaseRecordThreads();
+
+		vk::releaseTimestamps(vulkan);
 
 		vkFreeCommandBuffers(vulkan.device, vulkan.commandPool, commandBuffers.size(), commandBuffers.data());
-		if (modelSetPool) {
-			vkDestroyDescriptorPool(vulkan.device, modelSetPool, nullptr);
+		if (instanceSetPool) {
+			vkDestroyDescriptorPool(vulkan.device, instanceSetPool, nullptr);
 		}
 
 		if (cameraSetPool) {
 			vkDestroyDescriptorPool(vulkan.device, cameraSetPool, nullptr);
 		}
 
+		if (pushPipeline) {
+			vkDestroyPipeline(vulkan.device, pushPipeline, nullptr);
+		}
+
 		if (graphicsPipeline) {
 			vkDestroyPipeline(vulkan.device, graphicsPipeline, nullptr);
 		}
 
+		if (pushPipelineLayout) {
+			vkDestroyPipelineLayout(vulkan.device, pushPipelineLayout, nullptr);
+		}
+
 		if (pipelineLayout) {
 			vkDestroyPipelineLayout(vulkan.device, pipelineLayout, nullptr);
 		}
 
-		if (modelSetLayout) {
-			vkDestroyDescriptorSetLayout(vulkan.device, modelSetLayout, nullptr);
+		if (instanceSetLayout) {
+			vkDestroyDescriptorSetLayout(vulkan.device, instanceSetLayout, nullptr);
 		}
 
 		if (cameraSetLayout) {
 			vkDestroyDescriptorSetLayout(vulkan.device, cameraSetLayout, nullptr);
 		}
 
-		// UniformModel
-		if (modelMemory) {
-			vkFreeMemory(vulkan.device, modelMemory, nullptr);
-		}
-		
+		releaseFrameRing();
 
-		for (size_t j = 0; j < modelsBuffer.size(); j++) {
-			std::cout << j << std::endl;
-			if (modelsBuffer[j] != VK_NULL_HANDLE) {
-				vkDestroyBuffer(vulkan.device, modelsBuffer[j], nullptr);
-			}
-		}
-
-		if (stageModelMemory) {
-			vkFreeMemory(vulkan.device, stageModelMemory, nullptr);
-		}
-
-		for (size_t j = 0; j < stageModelsBuffer.size(); j++) {
-			if (stageModelsBuffer[j] != VK_NULL_HANDLE) {
-				vkDestroyBuffer(vulkan.device, stageModelsBuffer[j], nullptr);
-			}
-		}
-
-		models.clear();
-		stageModelsBuffer.clear();
-		modelsBuffer.clear();
-		modelOffsets.clear();
-		modelSize.clear();
-
-		// UniformCamera
-		if (cameraMemory) {
-			vkFreeMemory(vulkan.device, cameraMemory, nullptr);
-		}
-
-		if (cameraBuffer) {
-			vkDestroyBuffer(vulkan.device, cameraBuffer, nullptr);
-		}
-
-		if (stageCameraMemory) {
-			vkFreeMemory(vulkan.device, stageCameraMemory, nullptr);
-		}
-
-		if (stageCameraBuffer) {
-			vkDestroyBuffer(vulkan.device, stageCameraBuffer, nullptr);
-		}
+		quads.clear();
 
 		// Buffer
-		if (bufferMemory) {
-			vkFreeMemory(vulkan.device, bufferMemory, nullptr);
-		}
+		vk::freeMemory(vulkan, indexMemory);
+		vk::freeMemory(vulkan, verticesMemory);
 
 		if (indexBuffer) {
 			vkDestroyBuffer(vulkan.device, indexBuffer, nullptr);
@@ -343,18 +592,6 @@ namespace pong {
 			vkDestroyBuffer(vulkan.device, verticesBuffer, nullptr);
 		}
 
-		if (stageMemory) {
-			vkFreeMemory(vulkan.device, stageMemory, nullptr);
-		}
-
-		if (stageIndexBuffer) {
-			vkDestroyBuffer(vulkan.device, stageIndexBuffer, nullptr);
-		}
-
-		if (stageVerticesBuffer) {
-			vkDestroyBuffer(vulkan.device, stageVerticesBuffer, nullptr);
-		}
-
 		vk::releaseVulkan(vulkan);
 
 		audio::release();
@@ -362,7 +599,8 @@ namespace pong {
 		input::clearInputMaps();
 	}
 
-	void setup(app::Config* conf, AiPlayerType type) {
+	void setup(app::Config* conf, const Options& options) {
+		AiPlayerType type = options.aiPlayerType;
 
 		std::stringstream cap;
 
@@ -398,6 +636,40 @@ namespace pong {
 		conf->releaseCB = release;
 
 		aiPlayerType = type;
+		renderPath = options.renderPath;
+		benchmarkQuads = options.benchmarkQuads;
+
+		conf->headless = options.headless;
+		conf->frames = options.frames;
+		vulkan.headless = options.headless;
+		vulkan.framesInFlight = std::max(options.framesInFlight, 1u);
+
+		vulkan.presentMode = options.presentMode;
+		conf->targetFrameTime = (options.targetFps > 0) ? 1.0f / options.targetFps : 0.0f;
+		conf->waitFrameCB = waitFrame;
+		conf->tickRate = (float)options.tickRate;
+
+		recordPath = options.recordPath;
+		replayPath = options.replayPath;
+		replaySpeed = std::max(options.replaySpeed, 1u);
+		tickDelta = (options.tickRate > 0) ? (float)(1.0 / options.tickRate) : 0.0f;
+
+		netPlay = options.netPlay;
+
+		if (netPlay) {
+			netConfig.localPort = options.netPort;
+			netConfig.left = options.netHost;
+			netConfig.inputDelay = options.netDelay;
+
+			if (!net::parseAddress(options.netPeer, netConfig.remote)) {
+				throw std::runtime_error("Error: Net peer " + options.netPeer + " is not host:port");
+			}
+
+			// Rollback needs both peers stepping the same length of tick
+			if (options.tickRate == 0) {
+				conf->tickRate = 120.0f;
+			}
+		}
 	}
 
 	void initBuffers() {
@@ -416,386 +688,115 @@ namespace pong {
 			VkBufferCreateInfo vCI = {};
 			vCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 			vCI.size = verticesList.size() * sizeof(glm::vec3);
-			vCI.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-			vCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-			VkResult res = vkCreateBuffer(vulkan.device, &vCI, nullptr, &stageVerticesBuffer);
-
-			if (res != VK_SUCCESS) {
-				throw std::runtime_error("failed to create vertex buffer");
-			}
-			else {
-				std::cout << "Success: Created Vertex Buffer" << std::endl;
-			}
-
 			vCI.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			vk::shareWithTransfer(vulkan, vCI);
 
-			res = vkCreateBuffer(vulkan.device, &vCI, nullptr, &verticesBuffer);
-
-			if (res != VK_SUCCESS) {
-				throw std::runtime_error("failed to create vertex buffer");
-			}
-			else {
-				std::cout << "Success: Created Vertex Buffer" << std::endl;
-			}
-
-			VkMemoryRequirements vMemReq;
-			vkGetBufferMemoryRequirements(vulkan.device, stageVerticesBuffer, &vMemReq);
-
-			VkBufferCreateInfo iCI = {};
-			iCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-			iCI.size = indexList.size() * sizeof(uint32_t);
-			iCI.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-			iCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-			res = vkCreateBuffer(vulkan.device, &iCI, nullptr, &stageIndexBuffer);
-
-			if (res != VK_SUCCESS) {
-				throw std::runtime_error("failed to create index buffer");
-			}
-			else {
-				std::cout << "Success: Created Index Buffer" << std::endl;
-			}
-
-			iCI.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-
-			res = vkCreateBuffer(vulkan.device, &iCI, nullptr, &indexBuffer);
-
-			if (res != VK_SUCCESS) {
-				throw std::runtime_error("failed to create index buffer");
-			}
-			else {
-				std::cout << "Success: Created Index Buffer" << std::endl;
-			}
-
-			VkMemoryRequirements iMemReq;
-			vkGetBufferMemoryRequirements(vulkan.device, stageIndexBuffer, &iMemReq);
-
-			VkMemoryPropertyFlags p =
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-				VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-			VkPhysicalDeviceMemoryProperties memProps;
-			vkGetPhysicalDeviceMemoryProperties(vulkan.physicalDevice, &memProps);
-
-			std::optional<size_t> index;
-
-			for (size_t i = 0; i < memProps.memoryTypeCount; i++) {
-				if ((memProps.memoryTypes[i].propertyFlags & p) == p) {
-					index = i;
-				}
-			}
-
-			if (!index.has_value()) {
-				throw std::runtime_error("failed to find memory type");
-			}
-
-			verticesOffset = 0;
-			verticesSize = vMemReq.size;
-			
-			indexOffset = vMemReq.size;
-			if (indexOffset % iMemReq.alignment != 0) {
-				indexOffset += indexOffset % iMemReq.alignment;
-			}
-			indexSize = iMemReq.size;
-
-			VkDeviceSize maxSize = indexOffset + indexSize;
-
-			VkMemoryAllocateInfo allocInfo = {};
-			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-			allocInfo.allocationSize = maxSize;
-			allocInfo.memoryTypeIndex = index.value();
-
-			res = vkAllocateMemory(vulkan.device, &allocInfo, nullptr, &stageMemory);
-
-
-			if (res != VK_SUCCESS) {
-				throw std::runtime_error("failed to allocate bufferMemory");
-			}
-			else {
-				std::cout << "Success: Allocate BufferMemory" << std::endl;
-			}
-
-
-			vkBindBufferMemory(vulkan.device, stageVerticesBuffer, stageMemory, verticesOffset);
-			vkBindBufferMemory(vulkan.device, stageIndexBuffer, stageMemory, indexOffset);
-
-			void* data = nullptr;
-			vkMapMemory(vulkan.device, stageMemory, verticesOffset, verticesSize, 0, &data);
-			memcpy(data, verticesList.data(), (uint32_t)verticesSize);
-			vkUnmapMemory(vulkan.device, stageMemory);
-
-			vkMapMemory(vulkan.device, stageMemory, indexOffset, indexSize, 0, &data);
-			memcpy(data, indexList.data(), (uint32_t)indexSize);
-			vkUnmapMemory(vulkan.device, stageMemory);
-
-
-
-
-			// Create Device Local Memory
-			p = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-
-			for (size_t i = 0; i < memProps.memoryTypeCount; i++) {
-				if ((memProps.memoryTypes[i].propertyFlags & p) == p) {
-					index = i;
-				}
-			}
-
-			if (!index.has_value()) {
-				throw std::runtime_error("failed to find memory type");
-			}
-
-			/*
-			VkMemoryAllocateInfo allocInfo = {};
-			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-			allocInfo.allocationSize = maxSize;
-			*/
-			allocInfo.memoryTypeIndex = index.value();
-
-			res = vkAllocateMemory(vulkan.device, &allocInfo, nullptr, &bufferMemory);
-
-			if (res != VK_SUCCESS) {
-				throw std::runtime_error("failed to allocate bufferMemory");
-			}
-			else {
-				std::cout << "Success: Allocate BufferMemory" << std::endl;
-			}
-
-			vkBindBufferMemory(vulkan.device, verticesBuffer, bufferMemory, verticesOffset);
-			vkBindBufferMemory(vulkan.device, indexBuffer, bufferMemory, indexOffset);
-
-			// Copy Vertex Buffer
-			copyBuffer(stageVerticesBuffer, verticesBuffer, verticesSize);
-
-			// Copy Index Buffer
-			copyBuffer(stageIndexBuffer, indexBuffer, indexSize);
-
-		}
-
-		// Uniform Camera
-
-		{
-			VkBufferCreateInfo ucCI = {};
-			ucCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-			ucCI.size = sizeof(UniformCamera);
-			ucCI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-			ucCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-			VkResult res = vkCreateBuffer(vulkan.device, &ucCI, nullptr, &stageCameraBuffer);
-
-			if (res != VK_SUCCESS) {
-				std::runtime_error("failed to create cameraBuffer");
-			}
-			else {
-				std::cout << "Success: Create CameraBuffer" << std::endl;
-			}
-
-			ucCI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-
-			res = vkCreateBuffer(vulkan.device, &ucCI, nullptr, &cameraBuffer);
-
-			if (res != VK_SUCCESS) {
-				std::runtime_error("failed to create cameraBuffer");
-			}
-			else {
-				std::cout << "Success: Create CameraBuffer" << std::endl;
-			}
-
-			VkMemoryRequirements ucMemReq;
-			vkGetBufferMemoryRequirements(vulkan.device, cameraBuffer, &ucMemReq);
-
-			VkMemoryPropertyFlags p =
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-				VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-			VkPhysicalDeviceMemoryProperties memProps;
-			vkGetPhysicalDeviceMemoryProperties(vulkan.physicalDevice, &memProps);
-
-			std::optional<size_t> index;
-
-			for (size_t i = 0; i < memProps.memoryTypeCount; i++) {
-				if ((memProps.memoryTypes[i].propertyFlags & p) == p) {
-					index = i;
-				}
-			}
-
-			if (!index.has_value()) {
-				throw std::runtime_error("failed to find memory type");
-			}
-
-			VkMemoryAllocateInfo allocInfo = {};
-			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-			allocInfo.allocationSize = ucMemReq.size;
-			allocInfo.memoryTypeIndex = index.value();
-
-			res = vkAllocateMemory(vulkan.device, &allocInfo, nullptr, &stageCameraMemory);
-
-			if (res != VK_SUCCESS) {
-				std::runtime_error("failed to allocate cameraMemory");
-			}
-			else {
-				std::cout << "Success: Allocate CameraMemory" << std::endl;
-			}
-
-			vkBindBufferMemory(vulkan.device, stageCameraBuffer, stageCameraMemory, 0);
-
-			p = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			VkResult res = vkCreateBuffer(vulkan.device, &vCI, nullptr, &verticesBuffer);
 
-			for (size_t i = 0; i < memProps.memoryTypeCount; i++) {
-				if ((memProps.memoryTypes[i].propertyFlags & p) == p) {
-					index = i;
-				}
+			if (res != VK_SUCCESS) {
+				throw std::runtime_error("failed to create vertex buffer");
 			}
-
-			if (!index.has_value()) {
-				throw std::runtime_error("failed to find memory type");
+			else {
+				std::cout << "Success: Created Vertex Buffer" << std::endl;
 			}
 
-			allocInfo.memoryTypeIndex = index.value();
+			VkBufferCreateInfo iCI = {};
+			iCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			iCI.size = indexList.size() * sizeof(uint32_t);
+			iCI.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			vk::shareWithTransfer(vulkan, iCI);
 
-			res = vkAllocateMemory(vulkan.device, &allocInfo, nullptr, &cameraMemory);
+			res = vkCreateBuffer(vulkan.device, &iCI, nullptr, &indexBuffer);
 
 			if (res != VK_SUCCESS) {
-				std::runtime_error("failed to allocate cameraMemory");
+				throw std::runtime_error("failed to create index buffer");
 			}
 			else {
-				std::cout << "Success: Allocate CameraMemory" << std::endl;
+				std::cout << "Success: Created Index Buffer" << std::endl;
 			}
 
-			vkBindBufferMemory(vulkan.device, cameraBuffer, cameraMemory, 0);
-
+			verticesMemory = vk::allocateBuffer(vulkan, verticesBuffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			indexMemory = vk::allocateBuffer(vulkan, indexBuffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
+			// Both copies go out in one transfer submission. The first frame
+			// waits on its semaphore rather than blocking here.
+			vk::uploadBuffer(vulkan, verticesBuffer, 0, verticesList.data(), vCI.size);
+			vk::uploadBuffer(vulkan, indexBuffer, 0, indexList.data(), iCI.size);
+			vk::submitUploads(vulkan);
 		}
-		// Uniform Model
-		{
-			models.resize(numUniformModel);
-			stageModelsBuffer.resize(numUniformModel);
-			modelsBuffer.resize(numUniformModel);
-			modelOffsets.resize(numUniformModel);
-			modelSize.resize(numUniformModel);
-
-			std::vector<VkMemoryRequirements> reqs(numUniformModel);
-
-			// Create Staging Buffers
-			for (size_t i = 0; i < stageModelsBuffer.size(); i++) {
-				VkBufferCreateInfo CI = {};
-				CI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-				CI.size = sizeof(UniformModel);
-				CI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-				CI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-				VkResult res = vkCreateBuffer(vulkan.device, &CI, nullptr, &stageModelsBuffer[i]);
-
-				if (res != VK_SUCCESS) {
-					throw std::runtime_error("failed to modelBuffer");
-				}
-				else {
-					std::cout << "Success: Create modelBuffer["<< i <<"]" << std::endl;
-				}
-			}
-
-			// Creating Buffers
-			for (size_t i = 0; i < modelsBuffer.size(); i++) {
-				VkBufferCreateInfo CI = {};
-				CI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-				CI.size = sizeof(UniformModel);
-				CI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-				CI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-				VkResult res = vkCreateBuffer(vulkan.device, &CI, nullptr, &modelsBuffer[i]);
-
-				if (res != VK_SUCCESS) {
-					throw std::runtime_error("failed to modelBuffer");
-				}
-				else {
-					std::cout << "Success: Create modelBuffer[" << i << "]" << std::endl;
-				}
-			}
-			// Grab memory requirements
-			for (size_t i = 0; i < modelsBuffer.size(); i++) {
-				vkGetBufferMemoryRequirements(vulkan.device, modelsBuffer[i], &reqs[i]);
-			}
-
-			VkDeviceSize maxSize = 0;
-
-			modelOffsets[0] = 0;
-			modelSize[0] = reqs[0].size;
-
-			std::cout << modelOffsets[0] << ": " << modelSize[0] << std::endl;
-			for (size_t i = 1; i < reqs.size(); i++) {
-				modelOffsets[i] = modelOffsets[i - 1] + modelSize[i - 1];
-				modelSize[i] = reqs[i].size;
 
-				std::cout << modelOffsets[i] << ": " << modelSize[i] << std::endl;
-			}
-
-			maxSize = modelOffsets[modelOffsets.size() - 1] + modelSize[modelSize.size() - 1];
-
-			VkMemoryPropertyFlags p =
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-				VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		// Frame Ring
+		{
+			VkPhysicalDeviceProperties props;
+			vkGetPhysicalDeviceProperties(vulkan.physicalDevice, &props);
 
-			VkPhysicalDeviceMemoryProperties memProps;
-			vkGetPhysicalDeviceMemoryProperties(vulkan.physicalDevice, &memProps);
+			// A storage buffer can't be larger than maxStorageBufferRange, so
+			// that is the only limit on how many quads are drawn per frame.
+			uint32_t limit = props.limits.maxStorageBufferRange / sizeof(UniformModel);
 
-			std::optional<size_t> index;
+			maxInstances = std::max(maxInstances, 3 + benchmarkQuads);
 
-			for (size_t i = 0; i < memProps.memoryTypeCount; i++) {
-				if ((memProps.memoryTypes[i].propertyFlags & p) == p) {
-					index = i;
-				}
+			if (maxInstances > limit) {
+				maxInstances = limit;
 			}
 
-			if (!index.has_value()) {
-				throw std::runtime_error("failed to find memory type");
-			}
+			quads.reserve(maxInstances);
+			quads.resize(std::min(3 + benchmarkQuads, maxInstances));
 
-			VkMemoryAllocateInfo allocInfo = {};
-			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-			allocInfo.allocationSize = maxSize;
-			allocInfo.memoryTypeIndex = index.value();
+			instanceBufferSize = maxInstances * sizeof(UniformModel);
 
-			VkResult res = vkAllocateMemory(vulkan.device, &allocInfo, nullptr, &stageModelMemory);
+			// Both the camera and the instances are bound with dynamic
+			// offsets, so every slice and sub range must respect the
+			// stricter of the two offset alignments.
+			VkDeviceSize alignment = std::max(
+				props.limits.minUniformBufferOffsetAlignment,
+				props.limits.minStorageBufferOffsetAlignment);
 
-			if (res != VK_SUCCESS) {
-				throw std::runtime_error("failed to allocate modelMemory");
-			}
-			else {
-				std::cout << "Success: allocate modelMemory" << std::endl;
-			}
+			auto alignUp = [&](VkDeviceSize size) {
+				return (size + alignment - 1) / alignment * alignment;
+			};
 
-			p = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			ringInstanceOffset = alignUp(sizeof(UniformCamera));
+			ringSliceSize = alignUp(ringInstanceOffset + instanceBufferSize);
 
-			for (size_t i = 0; i < modelsBuffer.size(); i++) {
-				vkBindBufferMemory(vulkan.device, stageModelsBuffer[i], stageModelMemory, modelOffsets[i]);
-			}
+			initFrameRing();
+		}
+	}
 
-			for (size_t i = 0; i < memProps.memoryTypeCount; i++) {
-				if ((memProps.memoryTypes[i].propertyFlags & p) == p) {
-					index = i;
-				}
-			}
+	// One slice per swapchain image, so made again when the count changes
+	void initFrameRing() {
+		ringSliceCount = vulkan.swapchainImages.size();
 
-			if (!index.has_value()) {
-				throw std::runtime_error("failed to find memory type");
-			}
+		VkBufferCreateInfo CI = {};
+		CI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		CI.size = ringSliceSize * ringSliceCount;
+		CI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		CI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+		VkResult res = vkCreateBuffer(vulkan.device, &CI, nullptr, &ringBuffer);
 
-			allocInfo.memoryTypeIndex = index.value();
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to create ringBuffer");
+		}
+		else {
+			std::cout << "Success: Create RingBuffer" << std::endl;
+		}
 
-			res = vkAllocateMemory(vulkan.device, &allocInfo, nullptr, &modelMemory);
+		// Mapped once for the lifetime of the buffer.
+		ringMemory = vk::allocateBuffer(vulkan, ringBuffer,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-			if (res != VK_SUCCESS) {
-				throw std::runtime_error("failed to allocate modelMemory");
-			}
-			else {
-				std::cout << "Success: allocate modelMemory" << std::endl;
-			}
+		ringData = ringMemory.mapped;
+	}
 
-			for (size_t i = 0; i < modelsBuffer.size(); i++) {
-				vkBindBufferMemory(vulkan.device, modelsBuffer[i], modelMemory, modelOffsets[i]);
-			}
+	void releaseFrameRing() {
+		vk::freeMemory(vulkan, ringMemory);
+		ringData = nullptr;
 
+		if (ringBuffer) {
+			vkDestroyBuffer(vulkan.device, ringBuffer, nullptr);
+			ringBuffer = VK_NULL_HANDLE;
 		}
 	}
 
@@ -804,7 +805,7 @@ namespace pong {
 			VkDescriptorSetLayoutBinding uboCameraBinding = {};
 			uboCameraBinding.binding = 0;
 			uboCameraBinding.descriptorCount = 1;
-			uboCameraBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			uboCameraBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 			uboCameraBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
 			VkDescriptorSetLayoutCreateInfo layoutInfo = {};
@@ -823,18 +824,18 @@ namespace pong {
 			}
 		}
 		{
-			VkDescriptorSetLayoutBinding uboModelBinding = {};
-			uboModelBinding.binding = 1;
-			uboModelBinding.descriptorCount = numUniformModel;
-			uboModelBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			uboModelBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+			VkDescriptorSetLayoutBinding ssboInstanceBinding = {};
+			ssboInstanceBinding.binding = 0;
+			ssboInstanceBinding.descriptorCount = 1;
+			ssboInstanceBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+			ssboInstanceBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
 			VkDescriptorSetLayoutCreateInfo layoutInfo = {};
 			layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 			layoutInfo.bindingCount = 1;
-			layoutInfo.pBindings = &uboModelBinding;
+			layoutInfo.pBindings = &ssboInstanceBinding;
 
-			VkResult res = vkCreateDescriptorSetLayout(vulkan.device, &layoutInfo, nullptr, &modelSetLayout);
+			VkResult res = vkCreateDescriptorSetLayout(vulkan.device, &layoutInfo, nullptr, &instanceSetLayout);
 
 			//VkResult res = vkCreateDescriptorSetLayout(vulkan.device, &layoutInfo, nullptr, &descSetLayout);
 			if (res != VK_SUCCESS) {
@@ -847,7 +848,7 @@ namespace pong {
 
 		std::vector<VkDescriptorSetLayout> descSetLayouts = {
 			cameraSetLayout,
-			modelSetLayout
+			instanceSetLayout
 		};
 
 		VkPipelineLayoutCreateInfo CI = {};
@@ -863,17 +864,54 @@ namespace pong {
 		else {
 			std::cout << "Success: Created Pipeline Layout" << std::endl;
 		}
+
+		// Push Constant Layout
+		VkPushConstantRange pushRange = {};
+		pushRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushRange.offset = 0;
+		pushRange.size = sizeof(Quad);
+
+		VkPipelineLayoutCreateInfo pushCI = {};
+		pushCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pushCI.setLayoutCount = 1;
+		pushCI.pSetLayouts = &cameraSetLayout;
+		pushCI.pushConstantRangeCount = 1;
+		pushCI.pPushConstantRanges = &pushRange;
+
+		res = vkCreatePipelineLayout(vulkan.device, &pushCI, nullptr, &pushPipelineLayout);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to create push constant pipeline layout");
+		}
+		else {
+			std::cout << "Success: Created Push Constant Pipeline Layout" << std::endl;
+		}
 	}
 
 	void initGraphicsPipeline() {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		graphicsPipeline = createGraphicsPipeline("data/main.vert.spv", "data/main.frag.spv", pipelineLayout);
+
+		// F2 switches render paths while running, so both are always built
+		pushPipeline = createGraphicsPipeline("data/main_push.vert.spv", "data/main_push.frag.spv", pushPipelineLayout);
+
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+		std::cout << "Pipeline creation took "
+			<< std::chrono::duration<double, std::milli>(end - start).count() << " ms ("
+			<< (vulkan.pipelineCacheLoaded ? "with" : "without") << " pipeline cache)" << std::endl;
+	}
+
+	VkPipeline createGraphicsPipeline(std::string vertPath, std::string fragPath, VkPipelineLayout layout) {
 		// Vertex Shader
 		std::vector<char> vertexShaderData;
-		util::loadBlob("data/main.vert.spv", vertexShaderData);
+		util::loadBlob(vertPath, vertexShaderData);
 		VkShaderModule vertexShaderMod = vk::createShaderModule(vulkan, vertexShaderData);
 
 		// Fragment Shader
 		std::vector<char> fragShaderData;
-		util::loadBlob("data/main.frag.spv", fragShaderData);
+		util::loadBlob(fragPath, fragShaderData);
 		VkShaderModule fragShaderMod = vk::createShaderModule(vulkan, fragShaderData);
 
 		// Vertex PipelineStage
@@ -919,24 +957,23 @@ namespace pong {
 		inputAssembly.primitiveRestartEnable = VK_FALSE;
 
 		// viewport and scissor
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float)vulkan.swapchainExtent.width;
-		viewport.height = (float)vulkan.swapchainExtent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		VkRect2D scissor = {};
-		scissor.offset = { 0, 0 };
-		scissor.extent = vulkan.swapchainExtent;
-
+		// Both are set while recording so the pipeline outlives a resize
 		VkPipelineViewportStateCreateInfo viewportState = {};
 		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
+		viewportState.pViewports = nullptr;
 		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
+		viewportState.pScissors = nullptr;
+
+		std::vector<VkDynamicState> dynamicStates = {
+			VK_DYNAMIC_STATE_VIEWPORT,
+			VK_DYNAMIC_STATE_SCISSOR
+		};
+
+		VkPipelineDynamicStateCreateInfo dynamicState = {};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = dynamicStates.size();
+		dynamicState.pDynamicStates = dynamicStates.data();
 
 		//  Rasterizer
 		VkPipelineRasterizationStateCreateInfo rasterizer = {};
@@ -983,30 +1020,34 @@ namespace pong {
 		CI.pMultisampleState = &ms;
 		CI.pDepthStencilState = nullptr;
 		CI.pColorBlendState = &blend;
-		CI.pDynamicState = nullptr;
-		CI.layout = pipelineLayout;
+		CI.pDynamicState = &dynamicState;
+		CI.layout = layout;
 		CI.renderPass = vulkan.renderPass;
 		CI.subpass = 0;
 		CI.basePipelineHandle = VK_NULL_HANDLE;
 		CI.basePipelineIndex = -1;
 
+		VkPipeline pipeline;
+
 		VkResult res = vkCreateGraphicsPipelines(
 			vulkan.device,
-			VK_NULL_HANDLE,
+			vulkan.pipelineCache,
 			1,
 			&CI,
 			nullptr,
-			&graphicsPipeline);
+			&pipeline);
 
 		if (res != VK_SUCCESS) {
 			throw std::runtime_error("failed to create graphics pipeline");
 		}
 		else {
-			std::cout << "Success: Create Graphics Pipeline" << std::endl;
+			std::cout << "Success: Create Graphics Pipeline (" << vertPath << ")" << std::endl;
 		}
 
 		vkDestroyShaderModule(vulkan.device, vertexShaderMod, nullptr);
 		vkDestroyShaderModule(vulkan.device, fragShaderMod, nullptr);
+
+		return pipeline;
 	}
 
 	void initDescriptorPool() {
@@ -1014,7 +1055,7 @@ namespace pong {
 			// Camera Set Pool
 			VkDescriptorPoolSize uboSize = {};
 			uboSize.descriptorCount = 1;
-			uboSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			uboSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 
 
 			VkDescriptorPoolCreateInfo CI = {};
@@ -1033,18 +1074,18 @@ namespace pong {
 			}
 		}
 		{
-			// Model Set Pool
-			VkDescriptorPoolSize uboSize = {};
-			uboSize.descriptorCount = sizeof(UniformModel) * numUniformModel;
-			uboSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			// Instance Set Pool
+			VkDescriptorPoolSize ssboSize = {};
+			ssboSize.descriptorCount = 1;
+			ssboSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
 
 			VkDescriptorPoolCreateInfo CI = {};
 			CI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 			CI.poolSizeCount = 1;
-			CI.pPoolSizes = &uboSize;
-			CI.maxSets = numUniformModel;
+			CI.pPoolSizes = &ssboSize;
+			CI.maxSets = 1;
 
-			VkResult res = vkCreateDescriptorPool(vulkan.device, &CI, nullptr, &modelSetPool);
+			VkResult res = vkCreateDescriptorPool(vulkan.device, &CI, nullptr, &instanceSetPool);
 
 			if (res != VK_SUCCESS) {
 				throw std::runtime_error("failed to create descriptor pool");
@@ -1075,7 +1116,7 @@ namespace pong {
 			}
 
 			VkDescriptorBufferInfo bufferInfo = {};
-			bufferInfo.buffer = cameraBuffer;
+			bufferInfo.buffer = ringBuffer;
 			bufferInfo.offset = 0;
 			bufferInfo.range = sizeof(UniformCamera);
 
@@ -1084,7 +1125,7 @@ namespace pong {
 			descriptorWrite.dstSet = cameraSet;
 			descriptorWrite.dstBinding = 0;
 			descriptorWrite.dstArrayElement = 0;
-			descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 			descriptorWrite.descriptorCount = 1;
 			descriptorWrite.pBufferInfo = &bufferInfo;
 			
@@ -1092,468 +1133,441 @@ namespace pong {
 
 		}
 
-		// Models
+		// Instances
 		{
-			std::vector<VkDescriptorSetLayout> layouts(numUniformModel, modelSetLayout);
-
-			std::cout << layouts.size() << std::endl;
-
-			modelSet.resize(numUniformModel);
-
 			VkDescriptorSetAllocateInfo allocInfo = {};
 			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			allocInfo.descriptorPool = modelSetPool;
-			allocInfo.descriptorSetCount = layouts.size();
-			allocInfo.pSetLayouts = layouts.data();
+			allocInfo.descriptorPool = instanceSetPool;
+			allocInfo.descriptorSetCount = 1;
+			allocInfo.pSetLayouts = &instanceSetLayout;
 
-			VkResult res = vkAllocateDescriptorSets(vulkan.device, &allocInfo, modelSet.data());
+			VkResult res = vkAllocateDescriptorSets(vulkan.device, &allocInfo, &instanceSet);
 
 			if (res != VK_SUCCESS) {
-
-				switch (res) {
-				case VK_ERROR_OUT_OF_HOST_MEMORY:
-					std::cout << "Error out of host memory" << std::endl;
-					break;
-				case VK_ERROR_OUT_OF_DEVICE_MEMORY:
-					std::cout << "Error out of a device memory" << std::endl;
-					break;
-				case VK_ERROR_FRAGMENTED_POOL:
-					std::cout << "Error fragmented pool" << std::endl;
-					break;
-				case VK_ERROR_OUT_OF_POOL_MEMORY:
-					std::cout << "Error out of pool memory" << std::endl;
-					break;
-				}
-				throw std::runtime_error("failed to create model sets");
+				throw std::runtime_error("failed to allocate descriptor sets");
 			}
 			else {
-				std::cout << "Success: Allocated Model Descriptor Set" << std::endl;
+				std::cout << "Success: Allocated Instance Descriptor Set" << std::endl;
 			}
 
-			std::cout << modelSet.size() << std::endl;
-			std::vector<VkDescriptorBufferInfo> bi;
-			std::vector<VkWriteDescriptorSet> wds;
-
-			bi.resize(modelSet.size());
-			wds.resize(modelSet.size());
-
-			for (size_t i = 0; i < bi.size(); i++) {
-				bi[i].buffer = modelsBuffer[i];
-				bi[i].offset = 0;
-				bi[i].range = sizeof(UniformModel);
-			}
+			VkDescriptorBufferInfo bufferInfo = {};
+			bufferInfo.buffer = ringBuffer;
+			bufferInfo.offset = ringInstanceOffset;
+			bufferInfo.range = instanceBufferSize;
 
-			for (size_t i = 0; i < wds.size(); i++) {
-				wds[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				wds[i].dstSet = modelSet[i];
-				wds[i].dstBinding = 1;
-				wds[i].dstArrayElement = 0;
-				wds[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-				wds[i].descriptorCount = 1;
-				wds[i].pBufferInfo = &bi[i];
-			}
+			VkWriteDescriptorSet descriptorWrite = {};
+			descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrite.dstSet = instanceSet;
+			descriptorWrite.dstBinding = 0;
+			descriptorWrite.dstArrayElement = 0;
+			descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+			descriptorWrite.descriptorCount = 1;
+			descriptorWrite.pBufferInfo = &bufferInfo;
 
-			vkUpdateDescriptorSets(vulkan.device, wds.size(), wds.data(), 0, nullptr);
+			vkUpdateDescriptorSets(vulkan.device, 1, &descriptorWrite, 0, nullptr);
 		}
 	}
 
 	void initCommandBuffer() {
 		commandBuffers.resize(vulkan.swapchainImages.size());
+		recordedPath.resize(commandBuffers.size());
+		recordedQuads.resize(commandBuffers.size());
 
-		for (size_t i = 0; i < commandBuffers.size(); i++) {
-			VkCommandBufferAllocateInfo allocInfo = {};
-			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-			allocInfo.commandPool = vulkan.commandPool;
-			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-			allocInfo.commandBufferCount = 1;
-
-			VkResult res = vkAllocateCommandBuffers(vulkan.device, &allocInfo, &commandBuffers[i]);
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = vulkan.commandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = commandBuffers.size();
 
-			if (res != VK_SUCCESS) {
-				throw std::runtime_error("failed to allocate commandBuffer");
-			}
-			
-			VkCommandBufferBeginInfo beginInfo = {};
-			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			
-			res = vkBeginCommandBuffer(commandBuffers[i], &beginInfo);
+		VkResult res = vkAllocateCommandBuffers(vulkan.device, &allocInfo, commandBuffers.data());
 
-			if (res != VK_SUCCESS) {
-				throw std::runtime_error("failed to allocate Begin Command Buffer");
-			}
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate commandBuffer");
+		}
 
-			VkRenderPassBeginInfo renderPassInfo = {};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassInfo.renderPass = vulkan.renderPass;
-			renderPassInfo.framebuffer = vulkan.framebuffer[i];
-			renderPassInfo.renderArea.offset = { 0, 0 };
-			renderPassInfo.renderArea.extent = vulkan.swapchainExtent;
+		for (uint32_t i = 0; i < commandBuffers.size(); i++) {
+			recordInstancedCommandBuffer(i);
+		}
+	}
 
-			VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
-			renderPassInfo.clearValueCount = 1;
-			renderPassInfo.pClearValues = &clearColor;
-			
-			vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	void recordInstancedCommandBuffer(uint32_t image) {
+		VkCommandBuffer cb = commandBuffers[image];
 
-			// Do Stuff
-			vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+		vkResetCommandBuffer(cb, 0);
 
-			// Draw Quad
-			VkBuffer vertexBuffers[] = { verticesBuffer };
-			VkDeviceSize offset[] = { 0 };
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
-			vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offset);
-			vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		VkResult res = vkBeginCommandBuffer(cb, &beginInfo);
 
-			// Model
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate Begin Command Buffer");
+		}
 
-			std::vector<VkDescriptorSet> descSets = {
-				cameraSet,
-				modelSet[0]
-			};
+		vk::resetTimestamps(vulkan, cb, image);
+		vk::writeTimestamp(vulkan, cb, image, GpuTimestamp::GPU_PASS_BEGIN, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 
-			vkCmdBindDescriptorSets(
-				commandBuffers[i],
-				VK_PIPELINE_BIND_POINT_GRAPHICS,
-				pipelineLayout,
-				0,
-				descSets.size(),
-				descSets.data(),
-				0,
-				nullptr);
+		beginRenderPass(cb, image, VK_SUBPASS_CONTENTS_INLINE);
 
-			vkCmdDrawIndexed(commandBuffers[i], indexList.size(), 1, 0, 0, 0);
+		// Do Stuff
+		vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 
-			
-			vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offset);
-			vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		setViewport(cb);
 
-			// Model
-			
-			std::vector<VkDescriptorSet> descSets2 = {
-				cameraSet,
-				modelSet[1]
-			};
+		// Draw Quad
+		VkBuffer vertexBuffers[] = { verticesBuffer };
+		VkDeviceSize offset[] = { 0 };
 
-			
-			vkCmdBindDescriptorSets(
-				commandBuffers[i],
-				VK_PIPELINE_BIND_POINT_GRAPHICS,
-				pipelineLayout,
-				0,
-				descSets2.size(),
-				descSets2.data(),
-				0,
-				nullptr);
-
-			vkCmdDrawIndexed(commandBuffers[i], indexList.size(), 1, 0, 0, 0);
-			
+		vkCmdBindVertexBuffers(cb, 0, 1, vertexBuffers, offset);
+		vkCmdBindIndexBuffer(cb, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
 
-			// Draw Ball
-			vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offset);
-			vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		// Instances
+		std::vector<VkDescriptorSet> descSets = {
+			cameraSet,
+			instanceSet
+		};
 
-			// Model
+		// Both sets read from this image's slice of the frame ring.
+		std::vector<uint32_t> dynamicOffsets = {
+			(uint32_t)(image * ringSliceSize),
+			(uint32_t)(image * ringSliceSize)
+		};
 
-			std::vector<VkDescriptorSet> descSets3 = {
-				cameraSet,
-				modelSet[2]
-			};
+		vkCmdBindDescriptorSets(
+			cb,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			pipelineLayout,
+			0,
+			descSets.size(),
+			descSets.data(),
+			dynamicOffsets.size(),
+			dynamicOffsets.data());
 
+		// Paddles and Ball
+		vk::writeTimestamp(vulkan, cb, image, GpuTimestamp::GPU_DRAW_BEGIN, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 
-			vkCmdBindDescriptorSets(
-				commandBuffers[i],
-				VK_PIPELINE_BIND_POINT_GRAPHICS,
-				pipelineLayout,
-				0,
-				descSets3.size(),
-				descSets3.data(),
-				0,
-				nullptr);
+		vkCmdDrawIndexed(cb, indexList.size(), quads.size(), 0, 0, 0);
 
-			vkCmdDrawIndexed(commandBuffers[i], indexList.size(), 1, 0, 0, 0);
+		vk::writeTimestamp(vulkan, cb, image, GpuTimestamp::GPU_DRAW_END, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
 
-			vkCmdEndRenderPass(commandBuffers[i]);
+		vkCmdEndRenderPass(cb);
 
-			res = vkEndCommandBuffer(commandBuffers[i]);
+		vk::writeTimestamp(vulkan, cb, image, GpuTimestamp::GPU_PASS_END, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
 
-			if (res != VK_SUCCESS) {
-				throw std::runtime_error("failed to End Command Buffer");
-			}
+		res = vkEndCommandBuffer(cb);
 
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to End Command Buffer");
 		}
-	}
 
-	void toRect(util::Rect& r, Paddle& pad) {
-		r.init(pad.position, pad.size);
-	}
-	
-	void toRect(util::Rect& r, Ball& ball) {
-		r.init(ball.position, ball.size);
+		recordedPath[image] = RenderPath::RENDER_PATH_INSTANCED;
+		recordedQuads[image] = quads.size();
 	}
 
-	void updatePaddlePlayer(Paddle& pad, float delta) {
-		if (input::isInputMapPress("move-up")) {
-			pad.velocity.y = -1.0f;
+	void recordPushCommandBuffer(uint32_t image) {
+		VkCommandBuffer cb = commandBuffers[image];
 
-			if (pad.position.y < 0.0f) {
-				pad.velocity.y = 0.0f;
-			}
-		}
-		else if (input::isInputMapPress("move-down")) {
-			pad.velocity.y = 1.0f;
+		vkResetCommandBuffer(cb, 0);
 
-			if (pad.position.y + pad.size.y > vulkan.swapchainExtent.height) {
-				pad.velocity.y = 0.0f;
-			}
-		}
-		else {
-			pad.velocity.y = 0.0f;
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VkResult res = vkBeginCommandBuffer(cb, &beginInfo);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate Begin Command Buffer");
 		}
 
-		pad.position += pad.velocity * pad.speed * delta;
+		vk::resetTimestamps(vulkan, cb, image);
+		vk::writeTimestamp(vulkan, cb, image, GpuTimestamp::GPU_PASS_BEGIN, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 
-		models[0].model =
-			glm::translate(glm::mat4(1.0f), glm::vec3(pad.position, 0.0f)) *
-			glm::scale(glm::mat4(1.0f), glm::vec3(pad.size, 0.0f));
+		beginRenderPass(cb, image, VK_SUBPASS_CONTENTS_INLINE);
 
+		vk::writeTimestamp(vulkan, cb, image, GpuTimestamp::GPU_DRAW_BEGIN, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 
-	}
-	
-	void updatePaddleImpossible(Paddle& pad, float delta) {
+		recordQuads(cb, image, 0, quads.size());
 
-		if (ball.position.y + ball.size.y < pad.position.y) {
-			if (pad.position.y > 0.0f)
-				pad.velocity.y = -1.0f;
-			else
-				pad.velocity.y = 0.0f;
-		}
-		else if (ball.position.y > pad.position.y + pad.size.y) {
-			if (pad.position.y + pad.size.y < vulkan.swapchainExtent.height)
-				pad.velocity.y = 1.0f;
-			else
-				pad.velocity.y = 0.0f;
-		}
-		else {
-			pad.velocity.y = 0.0f;
-		}
+		vk::writeTimestamp(vulkan, cb, image, GpuTimestamp::GPU_DRAW_END, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
 
-		pad.position += pad.velocity * pad.speed * delta;
+		vkCmdEndRenderPass(cb);
+
+		vk::writeTimestamp(vulkan, cb, image, GpuTimestamp::GPU_PASS_END, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+		res = vkEndCommandBuffer(cb);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to End Command Buffer");
+		}
 
-		models[1].model = 
-			glm::translate(glm::mat4(1.0f), glm::vec3(pad.position, 0.0f)) *
-			glm::scale(glm::mat4(1.0f), glm::vec3(pad.size, 0.0f));
+		recordedPath[image] = RenderPath::RENDER_PATH_PUSH_CONSTANT;
+		recordedQuads[image] = quads.size();
 	}
-	
-	void updatePaddleExpert(Paddle& pad, float delta) {
-		if (ball.velocity.x > 0.0f) {
-			if (ball.position.y + ball.size.y < pad.position.y) {
-				if (pad.position.y > 0.0f)
-					pad.velocity.y = -1.0f;
-				else
-					pad.velocity.y = 0.0f;
-			}
-			else if (ball.position.y > pad.position.y + pad.size.y) {
-				if (pad.position.y + pad.size.y < vulkan.swapchainExtent.height)
-					pad.velocity.y = 1.0f;
-				else
-					pad.velocity.y = 0.0f;
-			}
-			else {
-				pad.velocity.y = 0.0f;
-			}
+
+	void recordParallelCommandBuffer(uint32_t image) {
+		if (recordThreads.empty()) {
+			initRecordThreads();
 		}
-		else {
-			pad.velocity.y = 0.0f;
+
+		// Every secondary recorded for this image last time has finished
+		for (auto& t : recordThreads) {
+			vkResetCommandPool(vulkan.device, t.pools[image], 0);
+			t.used[image] = 0;
 		}
 
-		pad.position += pad.velocity * pad.speed * delta;
+		uint32_t chunkCount = (quads.size() + recordChunkSize - 1) / recordChunkSize;
 
-		models[1].model =
-			glm::translate(glm::mat4(1.0f), glm::vec3(pad.position, 0.0f)) *
-			glm::scale(glm::mat4(1.0f), glm::vec3(pad.size, 0.0f));
-	}
+		chunkBuffers.resize(chunkCount);
+
+		util::parallelFor(recordPool, chunkCount, [&](uint32_t chunk, uint32_t thread) {
+			VkCommandBuffer cb = getRecordBuffer(thread, image);
+
+			VkCommandBufferInheritanceInfo inheritance = {};
+			inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			inheritance.renderPass = vulkan.renderPass;
+			inheritance.subpass = 0;
+			inheritance.framebuffer = vulkan.framebuffer[image];
+
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags =
+				VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+				VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+			beginInfo.pInheritanceInfo = &inheritance;
+
+			if (vkBeginCommandBuffer(cb, &beginInfo) != VK_SUCCESS) {
+				throw std::runtime_error("failed to Begin Secondary Command Buffer");
+			}
 
-	void updatePaddleHard(Paddle& pad, float delta) {
-		if (ball.velocity.x > 0.0f && ball.position.x > vulkan.swapchainExtent.width * 0.25f) {
-			if (ball.position.y + ball.size.y < pad.position.y) {
-				if (pad.position.y > 0.0f)
-					pad.velocity.y = -1.0f;
-				else
-					pad.velocity.y = 0.0f;
+			uint32_t first = chunk * recordChunkSize;
+			uint32_t count = std::min(recordChunkSize, (uint32_t)quads.size() - first);
+
+			// The primary can't write timestamps between executed secondaries,
+			// so the first and last chunk bracket the draws.
+			if (chunk == 0) {
+				vk::writeTimestamp(vulkan, cb, image, GpuTimestamp::GPU_DRAW_BEGIN, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 			}
-			else if (ball.position.y > pad.position.y + pad.size.y) {
-				if (pad.position.y + pad.size.y < vulkan.swapchainExtent.height)
-					pad.velocity.y = 1.0f;
-				else
-					pad.velocity.y = 0.0f;
+
+			recordQuads(cb, image, first, count);
+
+			if (chunk == chunkCount - 1) {
+				vk::writeTimestamp(vulkan, cb, image, GpuTimestamp::GPU_DRAW_END, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
 			}
-			else {
-				pad.velocity.y = 0.0f;
+
+			if (vkEndCommandBuffer(cb) != VK_SUCCESS) {
+				throw std::runtime_error("failed to End Secondary Command Buffer");
 			}
-		}
-		else {
-			pad.velocity.y = 0.0f;
+
+			chunkBuffers[chunk] = cb;
+		});
+
+		VkCommandBuffer cb = commandBuffers[image];
+
+		vkResetCommandBuffer(cb, 0);
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VkResult res = vkBeginCommandBuffer(cb, &beginInfo);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate Begin Command Buffer");
 		}
 
-		pad.position += pad.velocity * pad.speed * delta;
+		vk::resetTimestamps(vulkan, cb, image);
+		vk::writeTimestamp(vulkan, cb, image, GpuTimestamp::GPU_PASS_BEGIN, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 
-		models[1].model =
-			glm::translate(glm::mat4(1.0f), glm::vec3(pad.position, 0.0f)) *
-			glm::scale(glm::mat4(1.0f), glm::vec3(pad.size, 0.0f));
-	}
+		beginRenderPass(cb, image, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-	void updatePaddleNormal(Paddle& pad, float delta) {
-		if (ball.velocity.x > 0.0f && ball.position.x > vulkan.swapchainExtent.width * 0.5f) {
-			if (ball.position.y + ball.size.y < pad.position.y) {
-				if (pad.position.y > 0.0f)
-					pad.velocity.y = -1.0f;
-				else
-					pad.velocity.y = 0.0f;
-			}
-			else if (ball.position.y > pad.position.y + pad.size.y) {
-				if (pad.position.y + pad.size.y < vulkan.swapchainExtent.height)
-					pad.velocity.y = 1.0f;
-				else
-					pad.velocity.y = 0.0f;
-			}
-			else {
-				pad.velocity.y = 0.0f;
-			}
+		if (!chunkBuffers.empty()) {
+			vkCmdExecuteCommands(cb, chunkBuffers.size(), chunkBuffers.data());
 		}
-		else {
-			pad.velocity.y = 0.0f;
+
+		vkCmdEndRenderPass(cb);
+
+		vk::writeTimestamp(vulkan, cb, image, GpuTimestamp::GPU_PASS_END, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+		res = vkEndCommandBuffer(cb);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to End Command Buffer");
 		}
 
-		pad.position += pad.velocity * pad.speed * delta;
+		recordedPath[image] = RenderPath::RENDER_PATH_PARALLEL;
+		recordedQuads[image] = quads.size();
+	}
+
+	void setViewport(VkCommandBuffer cb) {
+		VkViewport viewport = {};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = (float)vulkan.swapchainExtent.width;
+		viewport.height = (float)vulkan.swapchainExtent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		VkRect2D scissor = {};
+		scissor.offset = { 0, 0 };
+		scissor.extent = vulkan.swapchainExtent;
 
-		models[1].model =
-			glm::translate(glm::mat4(1.0f), glm::vec3(pad.position, 0.0f)) *
-			glm::scale(glm::mat4(1.0f), glm::vec3(pad.size, 0.0f));
+		vkCmdSetViewport(cb, 0, 1, &viewport);
+		vkCmdSetScissor(cb, 0, 1, &scissor);
 	}
 
-	void updatePaddleEasy(Paddle& pad, float delta) {
-		if (ball.velocity.x > 0.0f && ball.position.x > vulkan.swapchainExtent.width * 0.75f) {
-			if (ball.position.y + ball.size.y < pad.position.y) {
-				if (pad.position.y > 0.0f)
-					pad.velocity.y = -1.0f;
-				else
-					pad.velocity.y = 0.0f;
-			}
-			else if (ball.position.y > pad.position.y + pad.size.y) {
-				if (pad.position.y + pad.size.y < vulkan.swapchainExtent.height)
-					pad.velocity.y = 1.0f;
-				else
-					pad.velocity.y = 0.0f;
-			}
-			else {
-				pad.velocity.y = 0.0f;
-			}
-		}
-		else {
-			pad.velocity.y = 0.0f;
-		}
+	void beginRenderPass(VkCommandBuffer cb, uint32_t image, VkSubpassContents contents) {
+		VkRenderPassBeginInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = vulkan.renderPass;
+		renderPassInfo.framebuffer = vulkan.framebuffer[image];
+		renderPassInfo.renderArea.offset = { 0, 0 };
+		renderPassInfo.renderArea.extent = vulkan.swapchainExtent;
 
-		pad.position += pad.velocity * pad.speed * delta;
+		VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+		renderPassInfo.clearValueCount = 1;
+		renderPassInfo.pClearValues = &clearColor;
 
-		models[1].model =
-			glm::translate(glm::mat4(1.0f), glm::vec3(pad.position, 0.0f)) *
-			glm::scale(glm::mat4(1.0f), glm::vec3(pad.size, 0.0f));
+		vkCmdBeginRenderPass(cb, &renderPassInfo, contents);
 	}
 
-	void resetBall(Ball& b) {
-		audio::playSoundFX("spawn-ball");
-		b.speed = glm::vec2(32.0f);
+	// Draws quads [first, first + count) with the push constant pipeline.
+	// Only reads shared state, so it is safe to call from the record threads.
+	void recordQuads(VkCommandBuffer cb, uint32_t image, uint32_t first, uint32_t count) {
+		vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, pushPipeline);
 
-		b.position = glm::vec2(
-			vulkan.swapchainExtent.width * 0.5f - b.size.x * 0.5f,
-			vulkan.swapchainExtent.height * 0.5f - b.size.y * 0.5f
-		);
+		// Dynamic state isn't inherited by secondaries, so every chunk sets it
+		setViewport(cb);
 
-		b.velocity = glm::vec2(
-			(mrand() % 2 == 0) ? -1.0f : 1.0f,
-			(mrand() % 2 == 0) ? -1.0f : 1.0f
-		);
+		VkBuffer vertexBuffers[] = { verticesBuffer };
+		VkDeviceSize offset[] = { 0 };
 
-	}
+		vkCmdBindVertexBuffers(cb, 0, 1, vertexBuffers, offset);
+		vkCmdBindIndexBuffer(cb, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
 
-	void updateBall(Ball& b, float delta) {
+		// Camera
+		uint32_t cameraOffset = (uint32_t)(image * ringSliceSize);
 
-		if (b.position.y < 0.0f) {
-			audio::playSoundFX("ball-hit");
-			b.velocity.y = 1.0f;
-		}
-		else if (b.position.y + b.size.y > vulkan.swapchainExtent.height) {
-			audio::playSoundFX("ball-hit");
-			b.velocity.y = -1.0f;
+		vkCmdBindDescriptorSets(
+			cb,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			pushPipelineLayout,
+			0,
+			1,
+			&cameraSet,
+			1,
+			&cameraOffset);
+
+		// Paddles and Ball
+		for (uint32_t i = first; i < first + count; i++) {
+			vkCmdPushConstants(cb, pushPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Quad), &quads[i]);
+			vkCmdDrawIndexed(cb, indexList.size(), 1, 0, 0, 0);
 		}
+	}
 
-		b.position += b.velocity * b.speed * delta;
+	void initRecordThreads() {
+		uint32_t cores = std::thread::hardware_concurrency();
 
-		if (b.position.x + b.size.x < 0.0f) {
-			//audio::playSoundFX("ai-player-score");
-			resetBall(b);
-		}
-		else if (b.position.x > vulkan.swapchainExtent.width) {
-			//audio::playSoundFX("player-score");
-			resetBall(b);
+		util::initThreadPool(recordPool, (cores > 1) ? cores - 1 : 0);
+
+		recordThreads.resize(util::getThreadCount(recordPool));
+
+		for (auto& t : recordThreads) {
+			t.pools.resize(vulkan.swapchainImages.size());
+			t.buffers.resize(vulkan.swapchainImages.size());
+			t.used.resize(vulkan.swapchainImages.size(), 0);
+
+			for (auto& pool : t.pools) {
+				VkCommandPoolCreateInfo poolInfo = {};
+				poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+				poolInfo.queueFamilyIndex = vulkan.graphicsFamily;
+				poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+				if (vkCreateCommandPool(vulkan.device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+					throw std::runtime_error("failed to create record command pool");
+				}
+			}
 		}
 
-		util::Rect br, p1r, p2r;
+		std::cout << "Success: Create Record Command Pools (" << recordThreads.size() << " threads)" << std::endl;
+	}
 
-		toRect(br, b);
-		toRect(p1r, player);
-		toRect(p2r, aiPlayer);
+	void releaseRecordThreads() {
+		util::releaseThreadPool(recordPool);
 
-		if (br.isCollide(p1r)) {
-			audio::playSoundFX("ball-hit");
-			b.velocity.x = 1.0f;
-			b.speed.x += b.speed.x * 0.1f;
+		// Destroying a pool frees the secondaries allocated from it
+		for (auto& t : recordThreads) {
+			for (auto& pool : t.pools) {
+				if (pool) {
+					vkDestroyCommandPool(vulkan.device, pool, nullptr);
+				}
+			}
 		}
 
-		if (br.isCollide(p2r)) {
-			audio::playSoundFX("ball-hit");
-			b.velocity.x = -1.0f;
-			b.speed.x += b.speed.x * 0.1f;
+		recordThreads.clear();
+		chunkBuffers.clear();
+	}
+
+	// Next free secondary of this thread's pool for the image, allocating
+	// one when a frame needs more chunks than any frame before it.
+	VkCommandBuffer getRecordBuffer(uint32_t thread, uint32_t image) {
+		RecordThread& t = recordThreads[thread];
+		std::vector<VkCommandBuffer>& buffers = t.buffers[image];
+
+		if (t.used[image] == buffers.size()) {
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = t.pools[image];
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer cb;
+
+			if (vkAllocateCommandBuffers(vulkan.device, &allocInfo, &cb) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate secondary commandBuffer");
+			}
+
+			buffers.push_back(cb);
 		}
 
-		models[2].model =
-			glm::translate(glm::mat4(1.0f), glm::vec3(b.position, 0.0f)) *
-			glm::scale(glm::mat4(1.0f), glm::vec3(b.size, 0.0f));
+		return buffers[t.used[image]++];
 	}
 
-	void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-		VkCommandBufferAllocateInfo ai = {};
-		ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		ai.commandPool = vulkan.commandPool;
-		ai.commandBufferCount = 1;
+	// A grid of small quads filling the screen, they never move.
+	void initBenchmarkQuads() {
+		uint32_t count = quads.size() - 3;
 
-		VkCommandBuffer cb;
-		vkAllocateCommandBuffers(vulkan.device, &ai, &cb);
+		if (count == 0) {
+			return;
+		}
 
-		VkCommandBufferBeginInfo bi = {};
-		bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		float width = (float)vulkan.swapchainExtent.width;
+		float height = (float)vulkan.swapchainExtent.height;
 
-		vkBeginCommandBuffer(cb, &bi);
+		uint32_t columns = (uint32_t)std::ceil(std::sqrt(count * width / height));
+		uint32_t rows = (count + columns - 1) / columns;
 
-		VkBufferCopy cr = {};
-		cr.srcOffset = 0;
-		cr.dstOffset = 0;
-		cr.size = size;
-		vkCmdCopyBuffer(cb, srcBuffer, dstBuffer, 1, &cr);
+		glm::vec2 cell = glm::vec2(width / columns, height / rows);
 
-		vkEndCommandBuffer(cb);
+		for (uint32_t i = 0; i < count; i++) {
+			Quad& q = quads[3 + i];
+			q.position = glm::vec2((i % columns) * cell.x, (i / columns) * cell.y);
+			q.size = cell * 0.5f;
+			q.color = glm::vec4(0.25f, 0.25f, 0.25f, 1.0f);
+		}
 
-		VkSubmitInfo sub = {};
-		sub.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		sub.commandBufferCount = 1;
-		sub.pCommandBuffers = &cb;
+		std::cout << "Benchmark: " << count << " extra quads" << std::endl;
+	}
 
-		vkQueueSubmit(vulkan.graphicsQueue, 1, &sub, VK_NULL_HANDLE);
-		vkQueueWaitIdle(vulkan.graphicsQueue);
+	// Drawn alpha of the way from the previous tick to the current one
+	void toQuad(Quad& q, const sim::Paddle& prev, const sim::Paddle& curr, float alpha) {
+		q.position = glm::mix(prev.position, curr.position, alpha);
+		q.size = curr.size;
+		q.color = glm::vec4(1.0f);
+	}
 
-		vkFreeCommandBuffers(vulkan.device, vulkan.commandPool, 1, &cb);
+	void toQuad(Quad& q, const sim::Ball& prev, const sim::Ball& curr, float alpha) {
+		q.position = glm::mix(prev.position, curr.position, alpha);
+		q.size = curr.size;
+		q.color = glm::vec4(1.0f);
 	}
 }
\ No newline at end of file
@@ -5,12 +5,41 @@
 
 
 namespace pong {
-	enum AiPlayerType {
-		AI_PLAYER_EASY = 0,
-		AI_PLAYER_NORMAL,
-		AI_PLAYER_HARD,
-		AI_PLAYER_EXPERT,
-		AI_PLAYER_IMPOSSIBLE
+	using AiPlayerType = sim::AiPlayerType;
+
+	enum RenderPath {
+		RENDER_PATH_INSTANCED = 0,
+		RENDER_PATH_PUSH_CONSTANT,
+		RENDER_PATH_PARALLEL,
+		RENDER_PATH_COUNT
+	};
+
+	struct Options {
+		AiPlayerType aiPlayerType = AiPlayerType::AI_PLAYER_EASY;
+		RenderPath renderPath = RenderPath::RENDER_PATH_INSTANCED;
+		uint32_t benchmarkQuads = 0;
+		// Render offscreen without a window for a fixed number of frames
+		bool headless = false;
+		uint32_t frames = 600;
+		// Frames recorded ahead of the GPU, 1 for latency, 3 for throughput
+		uint32_t framesInFlight = 2;
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+		// Frame pacer target, 0 runs as fast as the present mode allows
+		uint32_t targetFps = 0;
+		// Simulation ticks per second, 0 steps once per frame by frame time
+		uint32_t tickRate = 120;
+		// Log the match to recordPath, or play the one in replayPath
+		// replaySpeed ticks a tick and then hand it to the player.
+		std::string recordPath;
+		std::string replayPath;
+		uint32_t replaySpeed = 1;
+		// Two player match over UDP from netPort against netPeer, the host
+		// plays the left paddle and picks the seed.
+		bool netPlay = false;
+		bool netHost = false;
+		uint16_t netPort = 0;
+		std::string netPeer;
+		uint32_t netDelay = 2;
 	};
 
 	void init();
@@ -23,6 +52,6 @@ namespace pong {
 
 	void release();
 
-	void setup(app::Config* conf, AiPlayerType type);
+	void setup(app::Config* conf, const Options& options);
 
 }
\ No newline at end of file
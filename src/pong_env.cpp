@@ -0,0 +1,228 @@
+#define PONG_ENV_BUILD
+#include "pong_env.h"
+
+#include "sim.h"
+#include "thread_pool.h"
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+
+// Matches a parallelFor index steps, enough to keep the calls few and
+// few enough that every thread gets some.
+const uint32_t envShardSize = 256;
+
+struct PongEnv {
+	PongEnvConfig config;
+	float delta = 0.0f;
+
+	std::vector<sim::Match> matches;
+	// Episodes each match has started, part of the next one's seed
+	std::vector<uint32_t> episodes;
+
+	util::ThreadPool pool;
+
+	// Episodes each shard ended in the current step, kept so a step
+	// doesn't allocate
+	std::vector<uint32_t> shardFinished;
+
+	uint64_t steps = 0;
+	uint64_t finished = 0;
+	double seconds = 0.0;
+};
+
+namespace {
+	void startEpisode(PongEnv* env, uint32_t i) {
+		const PongEnvConfig& config = env->config;
+
+		sim::AiPlayerType type = (config.aiPlayerType == PONG_ENV_AI_MIXED) ?
+			(sim::AiPlayerType)(i % sim::AiPlayerType::AI_PLAYER_COUNT) : (sim::AiPlayerType)config.aiPlayerType;
+
+		// Every episode of every match gets a seed of its own
+		uint32_t seed = config.seed + i + env->episodes[i] * config.count;
+		env->episodes[i]++;
+
+		sim::initMatch(env->matches[i], glm::vec2(config.width, config.height), type, seed);
+	}
+
+	void writeObservation(const sim::Match& m, float* out) {
+		const glm::vec2 arena = m.arena;
+		const sim::Paddle& player = m.player;
+		const sim::Paddle& aiPlayer = m.aiPlayer;
+		const sim::Ball& ball = m.ball;
+
+		out[0] = (player.position.y + player.size.y * 0.5f) / arena.y;
+		out[1] = player.velocity.y * player.speed / arena.y;
+		out[2] = (aiPlayer.position.y + aiPlayer.size.y * 0.5f) / arena.y;
+		out[3] = aiPlayer.velocity.y * aiPlayer.speed / arena.y;
+		out[4] = (ball.position.x + ball.size.x * 0.5f) / arena.x;
+		out[5] = (ball.position.y + ball.size.y * 0.5f) / arena.y;
+		out[6] = ball.velocity.x * ball.speed.x / arena.x;
+		out[7] = ball.velocity.y * ball.speed.y / arena.y;
+	}
+}
+
+extern "C" {
+
+	void pong_env_default_config(PongEnvConfig* config) {
+		config->count = 4096;
+		config->threads = 0;
+		config->aiPlayerType = sim::AiPlayerType::AI_PLAYER_NORMAL;
+		config->points = 5;
+		config->maxTicks = 0;
+		config->frameSkip = 4;
+		config->tickRate = 120;
+		config->width = 640.0f;
+		config->height = 480.0f;
+		config->seed = 1;
+	}
+
+	PongEnv* pong_env_create(const PongEnvConfig* config) {
+		if (!config || config->count == 0 || config->aiPlayerType > PONG_ENV_AI_MIXED || config->points == 0 ||
+			config->frameSkip == 0 || config->tickRate == 0 || config->width <= 0.0f || config->height <= 0.0f) {
+			return nullptr;
+		}
+
+		// Nothing may throw past the C API, a failed allocation or thread
+		// is an env that couldn't be made.
+		PongEnv* env = nullptr;
+
+		try {
+			env = new PongEnv();
+			env->config = *config;
+			env->delta = 1.0f / config->tickRate;
+
+			env->matches.resize(config->count);
+			env->episodes.assign(config->count, 0);
+
+			for (uint32_t i = 0; i < config->count; i++) {
+				startEpisode(env, i);
+			}
+
+			uint32_t threads = config->threads;
+
+			if (threads == 0) {
+				threads = std::max(std::thread::hardware_concurrency(), 1u);
+			}
+
+			// No more threads than shards to give them
+			uint32_t shards = (config->count + envShardSize - 1) / envShardSize;
+			env->shardFinished.assign(shards, 0);
+			util::initThreadPool(env->pool, std::min(threads, shards) - 1);
+
+			return env;
+		}
+		catch (...) {
+			pong_env_destroy(env);
+			return nullptr;
+		}
+	}
+
+	void pong_env_destroy(PongEnv* env) {
+		if (!env) {
+			return;
+		}
+
+		util::releaseThreadPool(env->pool);
+		delete env;
+	}
+
+	uint32_t pong_env_count(const PongEnv* env) {
+		return env ? env->config.count : 0;
+	}
+
+	int pong_env_reset(PongEnv* env, float* observations) {
+		if (!env || !observations) {
+			return -1;
+		}
+
+		for (uint32_t i = 0; i < env->config.count; i++) {
+			startEpisode(env, i);
+			writeObservation(env->matches[i], observations + (size_t)i * PONG_ENV_OBSERVATION_SIZE);
+		}
+
+		return 0;
+	}
+
+	int pong_env_step(PongEnv* env, const uint8_t* actions, float* observations, float* rewards, uint8_t* dones) {
+		if (!env || !actions || !observations || !rewards || !dones) {
+			return -1;
+		}
+
+		// A job that threw is rethrown by parallelFor, it can't cross into C
+		try {
+			auto start = std::chrono::steady_clock::now();
+
+			const PongEnvConfig& config = env->config;
+			std::vector<uint32_t>& finished = env->shardFinished;
+			std::fill(finished.begin(), finished.end(), 0);
+
+			util::parallelFor(env->pool, (uint32_t)finished.size(), [&](uint32_t shard, uint32_t) {
+				uint32_t begin = shard * envShardSize;
+				uint32_t end = std::min(begin + envShardSize, config.count);
+
+				for (uint32_t i = begin; i < end; i++) {
+					sim::Match& m = env->matches[i];
+					uint32_t input = actions[i] & (sim::Input::INPUT_UP | sim::Input::INPUT_DOWN);
+					float reward = 0.0f;
+					uint8_t done = 0;
+
+					for (uint32_t t = 0; t < config.frameSkip; t++) {
+						uint32_t events = sim::step(m, input, env->delta);
+
+						if (events & sim::Event::EVENT_PLAYER_SCORE) {
+							reward += 1.0f;
+						}
+
+						if (events & sim::Event::EVENT_AI_PLAYER_SCORE) {
+							reward -= 1.0f;
+						}
+
+						if (m.playerScore >= config.points || m.aiPlayerScore >= config.points) {
+							done = PONG_ENV_DONE_TERMINATED;
+							break;
+						}
+
+						if (config.maxTicks > 0 && m.tick >= config.maxTicks) {
+							done = PONG_ENV_DONE_TRUNCATED;
+							break;
+						}
+					}
+
+					if (done) {
+						startEpisode(env, i);
+						finished[shard]++;
+					}
+
+					writeObservation(m, observations + (size_t)i * PONG_ENV_OBSERVATION_SIZE);
+					rewards[i] = reward;
+					dones[i] = done;
+				}
+			});
+
+			for (uint32_t count : finished) {
+				env->finished += count;
+			}
+
+			env->steps += config.count;
+			env->seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			return 0;
+		}
+		catch (...) {
+			return -1;
+		}
+	}
+
+	void pong_env_get_stats(const PongEnv* env, PongEnvStats* stats) {
+		if (!env || !stats) {
+			return;
+		}
+
+		stats->steps = env->steps;
+		stats->episodes = env->finished;
+		stats->seconds = env->seconds;
+		stats->stepsPerSecond = (env->seconds > 0.0) ? env->steps / env->seconds : 0.0;
+	}
+}
\ No newline at end of file
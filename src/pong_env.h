@@ -0,0 +1,108 @@
+#pragma once
+
+
+/*
+ * C API over many matches at once for training a paddle agent against the
+ * built in difficulties. The agent plays the left paddle of every match,
+ * the AI the right one. pong_env_step takes an action for every match and
+ * writes observations, rewards and done flags straight into the caller's
+ * arrays, one slice per match, from the threads that stepped them.
+ *
+ * A match that ends is started over in the same step, the observation
+ * written for it is the first of the new episode and its done flag says
+ * the last one ended.
+ *
+ * Built into a shared library with src/pong_env.cpp, src/sim.cpp,
+ * src/rect.cpp and src/thread_pool.cpp, with PONG_ENV_BUILD defined.
+ */
+
+#include <stdint.h>
+
+#ifdef _WIN32
+#ifdef PONG_ENV_BUILD
+#define PONG_ENV_API __declspec(dllexport)
+#else
+#define PONG_ENV_API __declspec(dllimport)
+#endif
+#else
+#define PONG_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Floats per match in observations, in this order:
+ * paddle center y, paddle velocity y, AI paddle center y, AI paddle
+ * velocity y, ball center x, ball center y, ball velocity x, ball
+ * velocity y. Positions are fractions of the arena, velocities arenas a
+ * second, y grows downwards.
+ */
+#define PONG_ENV_OBSERVATION_SIZE 8
+
+/* Actions, the same bits as sim::Input */
+#define PONG_ENV_ACTION_NONE 0
+#define PONG_ENV_ACTION_UP 1
+#define PONG_ENV_ACTION_DOWN 2
+
+/* Done flags, 0 while an episode goes on */
+#define PONG_ENV_DONE_TERMINATED 1
+#define PONG_ENV_DONE_TRUNCATED 2
+
+/* aiPlayerType of 0 to 4 is easy to impossible, this cycles match i through i % 5 */
+#define PONG_ENV_AI_MIXED 5
+
+typedef struct PongEnv PongEnv;
+
+typedef struct PongEnvConfig {
+	uint32_t count;
+	/* Threads stepping matches, the caller's included, 0 for one a core */
+	uint32_t threads;
+	uint32_t aiPlayerType;
+	/* An episode ends once either side has this many points */
+	uint32_t points;
+	/* An episode is cut off after this many ticks, 0 never */
+	uint32_t maxTicks;
+	/* Ticks a step runs with the same action */
+	uint32_t frameSkip;
+	uint32_t tickRate;
+	float width;
+	float height;
+	uint32_t seed;
+} PongEnvConfig;
+
+typedef struct PongEnvStats {
+	/* Matches stepped, a step of count matches adds count */
+	uint64_t steps;
+	uint64_t episodes;
+	/* Wall time spent in pong_env_step */
+	double seconds;
+	double stepsPerSecond;
+} PongEnvStats;
+
+/* 4096 matches against normal, first to 5, 4 ticks a step at 120 ticks/s, 640x480 */
+PONG_ENV_API void pong_env_default_config(PongEnvConfig* config);
+
+/* NULL if config is invalid or the matches or threads couldn't be made */
+PONG_ENV_API PongEnv* pong_env_create(const PongEnvConfig* config);
+PONG_ENV_API void pong_env_destroy(PongEnv* env);
+
+PONG_ENV_API uint32_t pong_env_count(const PongEnv* env);
+
+/* Starts every match over and writes count * PONG_ENV_OBSERVATION_SIZE floats */
+PONG_ENV_API int pong_env_reset(PongEnv* env, float* observations);
+
+/*
+ * actions holds count actions. Writes count * PONG_ENV_OBSERVATION_SIZE
+ * observations, count rewards (+1 a point won, -1 a point lost) and count
+ * done flags. Returns 0, or -1 if an argument is NULL or stepping failed,
+ * the outputs are then only partly written.
+ */
+PONG_ENV_API int pong_env_step(PongEnv* env, const uint8_t* actions, float* observations, float* rewards, uint8_t* dones);
+
+PONG_ENV_API void pong_env_get_stats(const PongEnv* env, PongEnvStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,320 @@
+#include "rect.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define RECT_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 in functions marked for it, MSVC in any
+#if defined(RECT_X86) && !defined(_MSC_VER)
+#define RECT_TARGET_SSE __attribute__((target("sse2")))
+#define RECT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RECT_TARGET_SSE
+#define RECT_TARGET_AVX2
+#endif
+
+
+void util::Rect::init(glm::vec2 p, glm::vec2 s) {
+	this->position = p;
+	this->size = s;
+}
+
+float util::Rect::left() {
+	return this->position.x;
+}
+
+float util::Rect::right() {
+	return this->position.x + this->size.x;
+}
+
+float util::Rect::top() {
+	return this->position.y;
+}
+
+float util::Rect::bottom() {
+	return this->position.y + this->size.y;
+}
+
+bool util::Rect::isCollide(Rect& r) {
+	return
+		this->left() < r.right() &&
+		this->right() > r.left() &&
+		this->top() < r.bottom() &&
+		this->bottom() > r.top();
+}
+
+bool util::sweepRect(const Rect& moving, glm::vec2 move, const Rect& still, float& time, glm::vec2& normal) {
+	const float left = moving.position.x;
+	const float right = moving.position.x + moving.size.x;
+	const float top = moving.position.y;
+	const float bottom = moving.position.y + moving.size.y;
+
+	const float stillLeft = still.position.x;
+	const float stillRight = still.position.x + still.size.x;
+	const float stillTop = still.position.y;
+	const float stillBottom = still.position.y + still.size.y;
+
+	// When each axis starts and stops overlapping, as fractions of move
+	float entryX = -INFINITY;
+	float exitX = INFINITY;
+	float entryY = -INFINITY;
+	float exitY = INFINITY;
+
+	if (move.x > 0.0f) {
+		entryX = (stillLeft - right) / move.x;
+		exitX = (stillRight - left) / move.x;
+	}
+	else if (move.x < 0.0f) {
+		entryX = (stillRight - left) / move.x;
+		exitX = (stillLeft - right) / move.x;
+	}
+	else if (right <= stillLeft || left >= stillRight) {
+		return false;
+	}
+
+	if (move.y > 0.0f) {
+		entryY = (stillTop - bottom) / move.y;
+		exitY = (stillBottom - top) / move.y;
+	}
+	else if (move.y < 0.0f) {
+		entryY = (stillBottom - top) / move.y;
+		exitY = (stillTop - bottom) / move.y;
+	}
+	else if (bottom <= stillTop || top >= stillBottom) {
+		return false;
+	}
+
+	float entry = std::max(entryX, entryY);
+	float exit = std::min(exitX, exitY);
+
+	// Touching edges don't count, same as isCollide
+	if (entry >= exit || entry > 1.0f || exit <= 0.0f) {
+		return false;
+	}
+
+	time = std::max(entry, 0.0f);
+
+	if (entryX > entryY) {
+		normal = glm::vec2((move.x > 0.0f) ? -1.0f : 1.0f, 0.0f);
+	}
+	else {
+		normal = glm::vec2(0.0f, (move.y > 0.0f) ? -1.0f : 1.0f);
+	}
+
+	return true;
+}
+
+// Boxes
+void util::addBox(Boxes& boxes, glm::vec2 position, glm::vec2 size) {
+	boxes.minX.push_back(position.x);
+	boxes.minY.push_back(position.y);
+	boxes.maxX.push_back(position.x + size.x);
+	boxes.maxY.push_back(position.y + size.y);
+}
+
+void util::clearBoxes(Boxes& boxes) {
+	boxes.minX.clear();
+	boxes.minY.clear();
+	boxes.maxX.clear();
+	boxes.maxY.clear();
+}
+
+uint32_t util::getBoxCount(const Boxes& boxes) {
+	return boxes.minX.size();
+}
+
+namespace util {
+
+	CollideLevel detectCollideLevel() {
+#if defined(RECT_X86) && defined(_MSC_VER)
+		int info[4];
+
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		bool sse2 = (info[3] & (1 << 26)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+
+		bool avx2 = false;
+		if (maxLeaf >= 7) {
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		// The OS has to save the ymm registers too
+		if (avx2 && avx && osxsave && (_xgetbv(0) & 6) == 6) {
+			return CollideLevel::COLLIDE_AVX2;
+		}
+
+		return sse2 ? CollideLevel::COLLIDE_SSE : CollideLevel::COLLIDE_SCALAR;
+#elif defined(RECT_X86)
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx2")) {
+			return CollideLevel::COLLIDE_AVX2;
+		}
+
+		return __builtin_cpu_supports("sse2") ? CollideLevel::COLLIDE_SSE : CollideLevel::COLLIDE_SCALAR;
+#else
+		return CollideLevel::COLLIDE_SCALAR;
+#endif
+	}
+
+	CollideLevel& currentCollideLevel() {
+		static CollideLevel level = detectCollideLevel();
+		return level;
+	}
+
+	uint32_t lowestBit(uint32_t bits) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, bits);
+		return index;
+#else
+		return __builtin_ctz(bits);
+#endif
+	}
+
+	uint32_t collideScalar(const Rect& r, const Boxes& boxes, uint32_t begin, uint32_t end, uint32_t* hits) {
+		const float left = r.position.x;
+		const float right = r.position.x + r.size.x;
+		const float top = r.position.y;
+		const float bottom = r.position.y + r.size.y;
+
+		uint32_t count = 0;
+
+		for (uint32_t i = begin; i < end; i++) {
+			// Written out rather than through Rect so nothing is branched on
+			bool hit =
+				(left < boxes.maxX[i]) &
+				(right > boxes.minX[i]) &
+				(top < boxes.maxY[i]) &
+				(bottom > boxes.minY[i]);
+
+			hits[count] = i;
+			count += hit;
+		}
+
+		return count;
+	}
+
+#ifdef RECT_X86
+	RECT_TARGET_SSE
+	uint32_t collideSSE(const Rect& r, const Boxes& boxes, uint32_t* hits) {
+		const uint32_t total = getBoxCount(boxes);
+
+		const __m128 left = _mm_set1_ps(r.position.x);
+		const __m128 right = _mm_set1_ps(r.position.x + r.size.x);
+		const __m128 top = _mm_set1_ps(r.position.y);
+		const __m128 bottom = _mm_set1_ps(r.position.y + r.size.y);
+
+		uint32_t count = 0;
+		uint32_t i = 0;
+
+		for (; i + 4 <= total; i += 4) {
+			__m128 x = _mm_and_ps(
+				_mm_cmplt_ps(left, _mm_loadu_ps(&boxes.maxX[i])),
+				_mm_cmpgt_ps(right, _mm_loadu_ps(&boxes.minX[i])));
+			__m128 y = _mm_and_ps(
+				_mm_cmplt_ps(top, _mm_loadu_ps(&boxes.maxY[i])),
+				_mm_cmpgt_ps(bottom, _mm_loadu_ps(&boxes.minY[i])));
+
+			uint32_t bits = _mm_movemask_ps(_mm_and_ps(x, y));
+
+			while (bits) {
+				hits[count++] = i + lowestBit(bits);
+				bits &= bits - 1;
+			}
+		}
+
+		return count + collideScalar(r, boxes, i, total, hits + count);
+	}
+
+	RECT_TARGET_AVX2
+	uint32_t collideAVX2(const Rect& r, const Boxes& boxes, uint32_t* hits) {
+		const uint32_t total = getBoxCount(boxes);
+
+		const __m256 left = _mm256_set1_ps(r.position.x);
+		const __m256 right = _mm256_set1_ps(r.position.x + r.size.x);
+		const __m256 top = _mm256_set1_ps(r.position.y);
+		const __m256 bottom = _mm256_set1_ps(r.position.y + r.size.y);
+
+		uint32_t count = 0;
+		uint32_t i = 0;
+
+		for (; i + 8 <= total; i += 8) {
+			__m256 x = _mm256_and_ps(
+				_mm256_cmp_ps(left, _mm256_loadu_ps(&boxes.maxX[i]), _CMP_LT_OQ),
+				_mm256_cmp_ps(right, _mm256_loadu_ps(&boxes.minX[i]), _CMP_GT_OQ));
+			__m256 y = _mm256_and_ps(
+				_mm256_cmp_ps(top, _mm256_loadu_ps(&boxes.maxY[i]), _CMP_LT_OQ),
+				_mm256_cmp_ps(bottom, _mm256_loadu_ps(&boxes.minY[i]), _CMP_GT_OQ));
+
+			uint32_t bits = _mm256_movemask_ps(_mm256_and_ps(x, y));
+
+			while (bits) {
+				hits[count++] = i + lowestBit(bits);
+				bits &= bits - 1;
+			}
+		}
+
+		return count + collideScalar(r, boxes, i, total, hits + count);
+	}
+#endif
+}
+
+util::CollideLevel util::getCollideLevel() {
+	return currentCollideLevel();
+}
+
+void util::setCollideLevel(CollideLevel level) {
+	currentCollideLevel() = std::min(level, detectCollideLevel());
+}
+
+const char* util::toString(CollideLevel level) {
+	switch (level) {
+	case CollideLevel::COLLIDE_SSE:
+		return "sse";
+	case CollideLevel::COLLIDE_AVX2:
+		return "avx2";
+	default:
+		return "scalar";
+	}
+}
+
+uint32_t util::collideBoxes(const Rect& r, const Boxes& boxes, uint32_t* hits) {
+	switch (currentCollideLevel()) {
+#ifdef RECT_X86
+	case CollideLevel::COLLIDE_AVX2:
+		return collideAVX2(r, boxes, hits);
+	case CollideLevel::COLLIDE_SSE:
+		return collideSSE(r, boxes, hits);
+#endif
+	default:
+		return collideScalar(r, boxes, 0, getBoxCount(boxes), hits);
+	}
+}
+
+void util::collideBoxes(const Boxes& a, const Boxes& b, std::vector<std::pair<uint32_t, uint32_t>>& pairs) {
+	std::vector<uint32_t> hits(getBoxCount(b));
+
+	for (uint32_t i = 0; i < getBoxCount(a); i++) {
+		Rect r;
+		r.init(glm::vec2(a.minX[i], a.minY[i]), glm::vec2(a.maxX[i] - a.minX[i], a.maxY[i] - a.minY[i]));
+
+		uint32_t count = collideBoxes(r, b, hits.data());
+
+		for (uint32_t h = 0; h < count; h++) {
+			pairs.push_back(std::make_pair(i, hits[h]));
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <glm/glm.hpp>
+
+namespace util {
+	struct Rect {
+		glm::vec2 position;
+		glm::vec2 size;
+
+		void init(glm::vec2 p, glm::vec2 s);
+
+		float left();
+		float right();
+		float top();
+		float bottom();
+
+		bool isCollide(Rect& r);
+	};
+
+	// Whether moving, displaced by move, touches still on the way. time is
+	// the fraction of move travelled when they first touch, 0 if they
+	// already overlap, and normal the face of still that was hit.
+	bool sweepRect(const Rect& moving, glm::vec2 move, const Rect& still, float& time, glm::vec2& normal);
+
+	// Many boxes as packed min and max arrays, the batch tests below read
+	// four or eight of them at once.
+	struct Boxes {
+		std::vector<float> minX;
+		std::vector<float> minY;
+		std::vector<float> maxX;
+		std::vector<float> maxY;
+	};
+
+	void addBox(Boxes& boxes, glm::vec2 position, glm::vec2 size);
+	void clearBoxes(Boxes& boxes);
+	uint32_t getBoxCount(const Boxes& boxes);
+
+	// The batch tests pick the widest of these the CPU runs the first time
+	// they're used. Setting it is for benchmarks, it can't go above what
+	// the CPU has.
+	enum CollideLevel {
+		COLLIDE_SCALAR = 0,
+		COLLIDE_SSE,
+		COLLIDE_AVX2
+	};
+
+	CollideLevel getCollideLevel();
+	void setCollideLevel(CollideLevel level);
+	const char* toString(CollideLevel level);
+
+	// Writes the index of every box overlapping r to hits, which needs room
+	// for all of them, and returns how many there were. Overlap is the same
+	// as Rect::isCollide, touching edges don't count.
+	uint32_t collideBoxes(const Rect& r, const Boxes& boxes, uint32_t* hits);
+
+	// Appends every overlapping (index in a, index in b) pair to pairs
+	void collideBoxes(const Boxes& a, const Boxes& b, std::vector<std::pair<uint32_t, uint32_t>>& pairs);
+}
\ No newline at end of file
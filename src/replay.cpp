@@ -0,0 +1,454 @@
+#include "replay.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+namespace replay {
+
+	const char replayMagic[8] = {'P', 'O', 'N', 'G', 'R', 'P', 'L', 'Y'};
+
+	// The writer thread gets the buffer once it holds this much, or every
+	// recordFlushTicks ticks so a crash loses at most a few seconds.
+	const size_t recordFlushSize = 64 * 1024;
+	const uint64_t recordFlushTicks = 1024;
+
+	void writeVarint(std::vector<uint8_t>& out, uint64_t value);
+	void writeFloat(std::vector<uint8_t>& out, float value);
+	void writeKey(Recorder& r, Record type);
+	void flushRecorder(Recorder& r);
+	void runWriter(Recorder& r);
+
+	bool readVarint(Player& p, uint64_t& value);
+	bool readFloat(Player& p, float& value);
+	void readKey(Player& p);
+	void readRecord(Player& p);
+	void readHeader(Player& p);
+
+	void openRecorder(Recorder& r, const std::string& path, const Header& header) {
+		r.file = fopen(path.c_str(), "wb");
+
+		if (!r.file) {
+			throw std::runtime_error("failed to create replay " + path);
+		}
+
+		r.buffer.assign(replayMagic, replayMagic + sizeof(replayMagic));
+		r.pending.clear();
+		r.closing = false;
+		r.tick = 0;
+		r.lastRecord = 0;
+		r.input = sim::Input::INPUT_NONE;
+		r.arena = header.arena;
+		r.delta = header.delta;
+		r.bytes = 0;
+
+		writeVarint(r.buffer, replayVersion);
+		writeVarint(r.buffer, header.seed);
+		writeVarint(r.buffer, header.aiPlayerType);
+		writeVarint(r.buffer, header.playerAi ? 1 : 0);
+		writeVarint(r.buffer, header.playerType);
+		writeFloat(r.buffer, header.arena.x);
+		writeFloat(r.buffer, header.arena.y);
+		writeFloat(r.buffer, header.delta);
+
+		r.thread = std::thread(runWriter, std::ref(r));
+
+		std::cout << "Success: Recording Replay " << path << " (seed " << header.seed << ")" << std::endl;
+	}
+
+	void recordTick(Recorder& r, uint32_t input, glm::vec2 arena, float delta) {
+		if (input != r.input) {
+			writeKey(r, Record::RECORD_INPUT);
+			writeVarint(r.buffer, input);
+			r.input = input;
+		}
+
+		if (arena != r.arena) {
+			writeKey(r, Record::RECORD_ARENA);
+			writeFloat(r.buffer, arena.x);
+			writeFloat(r.buffer, arena.y);
+			r.arena = arena;
+		}
+
+		if (delta != r.delta) {
+			writeKey(r, Record::RECORD_DELTA);
+			writeFloat(r.buffer, delta);
+			r.delta = delta;
+		}
+
+		r.tick++;
+
+		if (r.tick % recordFlushTicks == 0) {
+			// Repeating the input marks how far the log got, a log cut short
+			// plays up to its last record.
+			if (r.lastRecord < r.tick) {
+				writeKey(r, Record::RECORD_INPUT);
+				writeVarint(r.buffer, r.input);
+			}
+
+			flushRecorder(r);
+		}
+		else if (r.buffer.size() >= recordFlushSize) {
+			flushRecorder(r);
+		}
+	}
+
+	void closeRecorder(Recorder& r, const sim::Match& m) {
+		if (!r.file) {
+			return;
+		}
+
+		writeKey(r, Record::RECORD_END);
+		writeVarint(r.buffer, hashMatch(m));
+		flushRecorder(r);
+
+		{
+			std::lock_guard<std::mutex> lock(r.mutex);
+			r.closing = true;
+		}
+		r.wake.notify_one();
+		r.thread.join();
+
+		fclose(r.file);
+		r.file = nullptr;
+
+		std::cout << "Success: Recorded Replay (" << r.tick << " ticks, " << r.bytes << " bytes)" << std::endl;
+	}
+
+	void openPlayer(Player& p, const std::string& path) {
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error("failed to open replay " + path);
+		}
+
+		LARGE_INTEGER size;
+		GetFileSizeEx(file, &size);
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (!mapping) {
+			CloseHandle(file);
+			throw std::runtime_error("failed to map replay " + path);
+		}
+
+		p.file = file;
+		p.mapping = mapping;
+		p.size = (size_t)size.QuadPart;
+		p.data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+		p.file = open(path.c_str(), O_RDONLY);
+
+		if (p.file < 0) {
+			throw std::runtime_error("failed to open replay " + path);
+		}
+
+		struct stat st;
+		fstat(p.file, &st);
+		p.size = (size_t)st.st_size;
+
+		void* data = (p.size > 0) ? mmap(nullptr, p.size, PROT_READ, MAP_PRIVATE, p.file, 0) : MAP_FAILED;
+		p.data = (data != MAP_FAILED) ? (const uint8_t*)data : nullptr;
+
+		// Read front to back once
+		if (p.data) {
+			madvise(data, p.size, MADV_SEQUENTIAL);
+		}
+#endif
+
+		if (!p.data) {
+			closePlayer(p);
+			throw std::runtime_error("failed to map replay " + path);
+		}
+
+		try {
+			readHeader(p);
+		}
+		catch (...) {
+			closePlayer(p);
+			throw;
+		}
+
+		std::cout << "Success: Open Replay " << path << " (seed " << p.header.seed << ", " << p.size << " bytes)" << std::endl;
+	}
+
+	bool nextTick(Player& p, uint32_t& input, glm::vec2& arena, float& delta) {
+		while (!p.ended && p.nextRecord == p.tick) {
+			readRecord(p);
+		}
+
+		if (p.ended) {
+			return false;
+		}
+
+		input = p.input;
+		arena = p.arena;
+		delta = p.delta;
+
+		p.tick++;
+
+		return true;
+	}
+
+	void closePlayer(Player& p) {
+#ifdef _WIN32
+		if (p.data) {
+			UnmapViewOfFile(p.data);
+		}
+
+		if (p.mapping) {
+			CloseHandle(p.mapping);
+		}
+
+		if (p.file) {
+			CloseHandle(p.file);
+		}
+#else
+		if (p.data) {
+			munmap((void*)p.data, p.size);
+		}
+
+		if (p.file >= 0) {
+			close(p.file);
+		}
+#endif
+
+		p = Player();
+	}
+
+	uint32_t initMatch(sim::Match& m, const Header& header) {
+		uint32_t events = sim::initMatch(m, header.arena, header.aiPlayerType, header.seed);
+
+		m.playerAi = header.playerAi;
+		m.playerType = header.playerType;
+
+		return events;
+	}
+
+	uint32_t hashMatch(const sim::Match& m) {
+		uint32_t values[] = {
+			m.playerScore,
+			m.aiPlayerScore,
+			(uint32_t)m.tick,
+			(uint32_t)(m.tick >> 32),
+			0, 0, 0, 0
+		};
+
+		memcpy(&values[4], &m.player.position.y, sizeof(float));
+		memcpy(&values[5], &m.aiPlayer.position.y, sizeof(float));
+		memcpy(&values[6], &m.ball.position.x, sizeof(float));
+		memcpy(&values[7], &m.ball.position.y, sizeof(float));
+
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+
+		for (uint32_t value : values) {
+			for (uint32_t i = 0; i < 4; i++) {
+				hash = (hash ^ ((value >> (i * 8)) & 0xff)) * 16777619u;
+			}
+		}
+
+		return hash;
+	}
+
+	// 7 bits a byte, low bits first, the top bit set on all but the last
+	void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+		while (value >= 0x80) {
+			out.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+
+		out.push_back((uint8_t)value);
+	}
+
+	// Little endian whatever the machine
+	void writeFloat(std::vector<uint8_t>& out, float value) {
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(float));
+
+		for (uint32_t i = 0; i < 4; i++) {
+			out.push_back((uint8_t)(bits >> (i * 8)));
+		}
+	}
+
+	void writeKey(Recorder& r, Record type) {
+		writeVarint(r.buffer, ((r.tick - r.lastRecord) << 2) | type);
+		r.lastRecord = r.tick;
+	}
+
+	void flushRecorder(Recorder& r) {
+		if (r.buffer.empty()) {
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(r.mutex);
+			r.pending.insert(r.pending.end(), r.buffer.begin(), r.buffer.end());
+		}
+		r.wake.notify_one();
+
+		r.bytes += r.buffer.size();
+		r.buffer.clear();
+	}
+
+	void runWriter(Recorder& r) {
+		std::vector<uint8_t> chunk;
+
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(r.mutex);
+				r.wake.wait(lock, [&]() { return !r.pending.empty() || r.closing; });
+
+				if (r.pending.empty()) {
+					return;
+				}
+
+				chunk.swap(r.pending);
+			}
+
+			fwrite(chunk.data(), 1, chunk.size(), r.file);
+			fflush(r.file);
+			chunk.clear();
+		}
+	}
+
+	bool readVarint(Player& p, uint64_t& value) {
+		value = 0;
+
+		for (uint32_t shift = 0; shift < 64; shift += 7) {
+			if (p.offset >= p.size) {
+				return false;
+			}
+
+			uint8_t byte = p.data[p.offset++];
+			value |= (uint64_t)(byte & 0x7f) << shift;
+
+			if (!(byte & 0x80)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool readFloat(Player& p, float& value) {
+		if (p.offset + 4 > p.size) {
+			return false;
+		}
+
+		uint32_t bits = 0;
+
+		for (uint32_t i = 0; i < 4; i++) {
+			bits |= (uint32_t)p.data[p.offset++] << (i * 8);
+		}
+
+		memcpy(&value, &bits, sizeof(float));
+
+		return true;
+	}
+
+	void readKey(Player& p) {
+		uint64_t key;
+
+		if (!readVarint(p, key)) {
+			p.ended = true;
+			return;
+		}
+
+		p.nextRecord += key >> 2;
+		p.nextType = (Record)(key & 3);
+	}
+
+	void readRecord(Player& p) {
+		bool read = true;
+
+		switch (p.nextType) {
+		case Record::RECORD_INPUT: {
+			uint64_t input;
+			read = readVarint(p, input);
+			p.input = (uint32_t)input;
+			break;
+		}
+		case Record::RECORD_ARENA:
+			read = readFloat(p, p.arena.x) && readFloat(p, p.arena.y);
+			break;
+		case Record::RECORD_DELTA:
+			read = readFloat(p, p.delta);
+			break;
+		case Record::RECORD_END: {
+			uint64_t hash;
+			p.hasHash = readVarint(p, hash);
+			p.hash = (uint32_t)hash;
+			p.ended = true;
+			return;
+		}
+		}
+
+		if (!read) {
+			p.ended = true;
+			return;
+		}
+
+		readKey(p);
+	}
+
+	void readHeader(Player& p) {
+		if (p.size < sizeof(replayMagic) || memcmp(p.data, replayMagic, sizeof(replayMagic)) != 0) {
+			throw std::runtime_error("not a replay");
+		}
+
+		p.offset = sizeof(replayMagic);
+
+		uint64_t version, seed, aiPlayerType, playerAi, playerType;
+
+		bool read =
+			readVarint(p, version) &&
+			readVarint(p, seed) &&
+			readVarint(p, aiPlayerType) &&
+			readVarint(p, playerAi) &&
+			readVarint(p, playerType) &&
+			readFloat(p, p.header.arena.x) &&
+			readFloat(p, p.header.arena.y) &&
+			readFloat(p, p.header.delta);
+
+		if (!read) {
+			throw std::runtime_error("replay header cut short");
+		}
+
+		if (version != replayVersion) {
+			throw std::runtime_error("unsupported replay version " + std::to_string(version));
+		}
+
+		if (aiPlayerType >= sim::AiPlayerType::AI_PLAYER_COUNT || playerType >= sim::AiPlayerType::AI_PLAYER_COUNT) {
+			throw std::runtime_error("replay has an unknown difficulty");
+		}
+
+		p.header.seed = (uint32_t)seed;
+		p.header.aiPlayerType = (sim::AiPlayerType)aiPlayerType;
+		p.header.playerAi = playerAi != 0;
+		p.header.playerType = (sim::AiPlayerType)playerType;
+
+		p.tick = 0;
+		p.nextRecord = 0;
+		p.input = sim::Input::INPUT_NONE;
+		p.arena = p.header.arena;
+		p.delta = p.header.delta;
+		p.ended = false;
+		p.hasHash = false;
+
+		readKey(p);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+
+// Recording a match as its seed and the player's input each tick, which is
+// all sim needs to play it again exactly, and playing such a log back at
+// any speed with or without the game running.
+//
+// A log is a header followed by records. Every record starts with a varint
+// of the ticks since the record before shifted left by 2 and its Record
+// type, so a tick costs nothing unless the input, arena or tick length
+// changed in it.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <glm/glm.hpp>
+
+#include "sim.h"
+
+namespace replay {
+	// 2 since Match's rng became an xorshift, 3 since a serve makes the AI
+	// aim again, logs of an older version play differently.
+	const uint32_t replayVersion = 3;
+
+	enum Record {
+		// varint of the Input bits held from this tick on
+		RECORD_INPUT = 0,
+		// arena width and height as raw floats
+		RECORD_ARENA,
+		// tick length as a raw float
+		RECORD_DELTA,
+		// varint of hashMatch after the last tick, nothing follows
+		RECORD_END
+	};
+
+	// Everything initMatch needs plus the state of the first tick
+	struct Header {
+		uint32_t seed = 0;
+		sim::AiPlayerType aiPlayerType = sim::AiPlayerType::AI_PLAYER_EASY;
+		bool playerAi = false;
+		sim::AiPlayerType playerType = sim::AiPlayerType::AI_PLAYER_EASY;
+		glm::vec2 arena = glm::vec2(0.0f);
+		float delta = 0.0f;
+	};
+
+	// Encodes on the game's thread and hands the bytes to a thread of its
+	// own to write, so a slow disk never holds up a tick.
+	struct Recorder {
+		FILE* file = nullptr;
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable wake;
+		// Filled by recordTick, moved to pending every flush
+		std::vector<uint8_t> buffer;
+		// Waiting for the writer thread
+		std::vector<uint8_t> pending;
+		bool closing = false;
+
+		uint64_t tick = 0;
+		uint64_t lastRecord = 0;
+		uint32_t input = 0;
+		glm::vec2 arena = glm::vec2(0.0f);
+		float delta = 0.0f;
+		uint64_t bytes = 0;
+	};
+
+	// Reads a log through a memory mapping of the whole file
+	struct Player {
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+		size_t offset = 0;
+#ifdef _WIN32
+		void* file = nullptr;
+		void* mapping = nullptr;
+#else
+		int file = -1;
+#endif
+
+		Header header;
+
+		uint64_t tick = 0;
+		// Tick and type of the record read next
+		uint64_t nextRecord = 0;
+		Record nextType = Record::RECORD_END;
+
+		uint32_t input = 0;
+		glm::vec2 arena = glm::vec2(0.0f);
+		float delta = 0.0f;
+
+		// Set by RECORD_END, a log cut short by a crash has no hash
+		bool ended = false;
+		bool hasHash = false;
+		uint32_t hash = 0;
+	};
+
+	// Throws if the file can't be created
+	void openRecorder(Recorder& r, const std::string& path, const Header& header);
+
+	// Called before every sim::step with what it is about to be given
+	void recordTick(Recorder& r, uint32_t input, glm::vec2 arena, float delta);
+
+	// Ends the log with m's hash and waits until all of it is written
+	void closeRecorder(Recorder& r, const sim::Match& m);
+
+	// Throws if the file can't be read or isn't a log
+	void openPlayer(Player& p, const std::string& path);
+
+	// What to give the next sim::step, false once the log has no more ticks
+	bool nextTick(Player& p, uint32_t& input, glm::vec2& arena, float& delta);
+
+	void closePlayer(Player& p);
+
+	// The match as of the header, returns initMatch's events
+	uint32_t initMatch(sim::Match& m, const Header& header);
+
+	// Scores, tick and positions, for checking a playback ended where the
+	// recording did.
+	uint32_t hashMatch(const sim::Match& m);
+}
\ No newline at end of file
@@ -0,0 +1,535 @@
+#include "server.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+
+namespace server {
+
+	// Packets read or written per recvmmsg / sendmmsg call
+	const uint32_t batchSize = 64;
+
+	// Ticks run at once after the thread was held up, the rest are dropped
+	const uint64_t maxCatchUp = 4;
+
+	const int socketBufferSize = 4 * 1024 * 1024;
+
+	void runShard(Server& s, Shard& shard);
+	void receivePackets(Server& s, Shard& shard, ShardStats& stats);
+	void handlePacket(Server& s, Shard& shard, const ClientPacket& packet, const sockaddr_in& from, ShardStats& stats);
+	void tickShard(Server& s, Shard& shard, ShardStats& stats);
+	void removeGame(Shard& shard, uint32_t index);
+	void releaseShard(Shard& shard);
+
+	void putU32(uint8_t* out, uint32_t value);
+	uint32_t getU32(const uint8_t* data);
+
+	size_t writeClientPacket(uint8_t* out, const ClientPacket& packet) {
+		out[0] = 'P';
+		out[1] = 'S';
+		out[2] = protocolVersion;
+		out[3] = (uint8_t)packet.type;
+		putU32(out + 4, packet.token);
+		putU32(out + 8, packet.ack);
+		putU32(out + 12, packet.echo);
+		out[16] = packet.input;
+		out[17] = packet.aiPlayerType;
+
+		return clientPacketSize;
+	}
+
+	bool readClientPacket(const uint8_t* data, size_t size, ClientPacket& packet) {
+		if (size < clientPacketSize || data[0] != 'P' || data[1] != 'S' || data[2] != protocolVersion || data[3] > Message::MESSAGE_LEAVE) {
+			return false;
+		}
+
+		packet.type = (Message)data[3];
+		packet.token = getU32(data + 4);
+		packet.ack = getU32(data + 8);
+		packet.echo = getU32(data + 12);
+		packet.input = data[16] & (sim::Input::INPUT_UP | sim::Input::INPUT_DOWN);
+		packet.aiPlayerType = std::min(data[17], (uint8_t)(sim::AiPlayerType::AI_PLAYER_COUNT - 1));
+
+		return true;
+	}
+
+	void toState(const sim::Match& m, State& state) {
+		state.tick = (uint32_t)m.tick;
+
+		std::memcpy(&state.fields[Field::FIELD_PLAYER_Y], &m.player.position.y, 4);
+		std::memcpy(&state.fields[Field::FIELD_AI_PLAYER_Y], &m.aiPlayer.position.y, 4);
+		std::memcpy(&state.fields[Field::FIELD_BALL_X], &m.ball.position.x, 4);
+		std::memcpy(&state.fields[Field::FIELD_BALL_Y], &m.ball.position.y, 4);
+		std::memcpy(&state.fields[Field::FIELD_BALL_VELOCITY_X], &m.ball.velocity.x, 4);
+		std::memcpy(&state.fields[Field::FIELD_BALL_VELOCITY_Y], &m.ball.velocity.y, 4);
+		state.fields[Field::FIELD_PLAYER_SCORE] = m.playerScore;
+		state.fields[Field::FIELD_AI_PLAYER_SCORE] = m.aiPlayerScore;
+	}
+
+	size_t writeState(uint8_t* out, uint32_t token, const State& state, const State* base, uint32_t echo, uint8_t events) {
+		out[0] = 'P';
+		out[1] = 'S';
+		out[2] = protocolVersion;
+		out[3] = Message::MESSAGE_STATE;
+		putU32(out + 4, token);
+		putU32(out + 8, state.tick);
+		putU32(out + 12, base ? base->tick : noTick);
+		putU32(out + 16, echo);
+		out[20] = events;
+
+		uint8_t mask = 0;
+		size_t size = stateHeaderSize;
+
+		for (uint32_t i = 0; i < Field::FIELD_COUNT; i++) {
+			if (!base || base->fields[i] != state.fields[i]) {
+				mask |= 1 << i;
+				putU32(out + size, state.fields[i]);
+				size += 4;
+			}
+		}
+
+		out[21] = mask;
+
+		return size;
+	}
+
+	bool readState(const uint8_t* data, size_t size, StatePacket& packet) {
+		if (size < stateHeaderSize || data[0] != 'P' || data[1] != 'S' || data[2] != protocolVersion || data[3] != Message::MESSAGE_STATE) {
+			return false;
+		}
+
+		packet.token = getU32(data + 4);
+		packet.tick = getU32(data + 8);
+		packet.baseTick = getU32(data + 12);
+		packet.echo = getU32(data + 16);
+		packet.events = data[20];
+		packet.mask = data[21];
+
+		size_t offset = stateHeaderSize;
+
+		for (uint32_t i = 0; i < Field::FIELD_COUNT; i++) {
+			if (packet.mask & (1 << i)) {
+				if (offset + 4 > size) {
+					return false;
+				}
+
+				packet.fields[i] = getU32(data + offset);
+				offset += 4;
+			}
+		}
+
+		// A full state has to have every field
+		return packet.baseTick != noTick || packet.mask == (1 << Field::FIELD_COUNT) - 1;
+	}
+
+	void applyState(const StatePacket& packet, const State& base, State& state) {
+		for (uint32_t i = 0; i < Field::FIELD_COUNT; i++) {
+			state.fields[i] = (packet.mask & (1 << i)) ? packet.fields[i] : base.fields[i];
+		}
+
+		state.tick = packet.tick;
+	}
+
+	float getField(const State& state, Field field) {
+		float value;
+		std::memcpy(&value, &state.fields[field], 4);
+		return value;
+	}
+
+	void startServer(Server& s, const Config& config) {
+		s.config = config;
+		s.config.tickRate = std::max(config.tickRate, 1u);
+		s.config.sendInterval = std::max(config.sendInterval, 1u);
+
+		uint32_t threads = config.threads;
+
+		if (threads == 0) {
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		s.shards.clear();
+
+		for (uint32_t i = 0; i < threads; i++) {
+			s.shards.push_back(std::make_unique<Shard>());
+			Shard& shard = *s.shards.back();
+
+			// Every shard binds the same port, SO_REUSEPORT has the kernel
+			// hash each client's address to one of them.
+			shard.socket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_UDP);
+
+			if (shard.socket < 0) {
+				throw std::runtime_error("failed to create socket");
+			}
+
+			int on = 1;
+			setsockopt(shard.socket, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+			setsockopt(shard.socket, SOL_SOCKET, SO_RCVBUF, &socketBufferSize, sizeof(socketBufferSize));
+			setsockopt(shard.socket, SOL_SOCKET, SO_SNDBUF, &socketBufferSize, sizeof(socketBufferSize));
+
+			sockaddr_in addr = {};
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_ANY);
+			addr.sin_port = htons(config.port);
+
+			if (bind(shard.socket, (sockaddr*)&addr, sizeof(addr)) != 0) {
+				throw std::runtime_error("failed to bind port " + std::to_string(config.port));
+			}
+
+			shard.timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+
+			if (shard.timer < 0) {
+				throw std::runtime_error("failed to create tick timer");
+			}
+
+			long period = 1000000000L / s.config.tickRate;
+
+			itimerspec spec = {};
+			spec.it_interval.tv_sec = period / 1000000000L;
+			spec.it_interval.tv_nsec = period % 1000000000L;
+			spec.it_value = spec.it_interval;
+			timerfd_settime(shard.timer, 0, &spec, nullptr);
+
+			shard.epoll = epoll_create1(0);
+
+			if (shard.epoll < 0) {
+				throw std::runtime_error("failed to create epoll");
+			}
+
+			epoll_event event = {};
+			event.events = EPOLLIN;
+			event.data.fd = shard.socket;
+			epoll_ctl(shard.epoll, EPOLL_CTL_ADD, shard.socket, &event);
+
+			event.data.fd = shard.timer;
+			epoll_ctl(shard.epoll, EPOLL_CTL_ADD, shard.timer, &event);
+		}
+
+		s.running = true;
+
+		for (auto& shard : s.shards) {
+			Shard* p = shard.get();
+			shard->thread = std::thread([&s, p]() { runShard(s, *p); });
+		}
+
+		std::cout << "Success: Start Server (port " << config.port << ", " << threads << " shards, "
+			<< s.config.tickRate << " ticks/s)" << std::endl;
+	}
+
+	void stopServer(Server& s) {
+		s.running = false;
+
+		for (auto& shard : s.shards) {
+			if (shard->thread.joinable()) {
+				shard->thread.join();
+			}
+
+			releaseShard(*shard);
+		}
+
+		s.shards.clear();
+	}
+
+	void takeStats(Server& s, ShardStats& total) {
+		total = ShardStats();
+
+		for (auto& shard : s.shards) {
+			std::lock_guard<std::mutex> lock(shard->statsMutex);
+			ShardStats& stats = shard->stats;
+
+			total.matches += stats.matches;
+			total.ticks += stats.ticks;
+			total.joins += stats.joins;
+			total.leaves += stats.leaves;
+			total.timeouts += stats.timeouts;
+			total.packetsIn += stats.packetsIn;
+			total.packetsOut += stats.packetsOut;
+			total.bytesOut += stats.bytesOut;
+			total.fullStates += stats.fullStates;
+			total.busy += stats.busy;
+			total.tickTimes.insert(total.tickTimes.end(), stats.tickTimes.begin(), stats.tickTimes.end());
+
+			// The match count is a level, not a total
+			uint64_t matches = stats.matches;
+			stats = ShardStats();
+			stats.matches = matches;
+		}
+	}
+
+	void runShard(Server& s, Shard& shard) {
+		epoll_event events[2];
+
+		// Kept here and handed over under the lock after every wake up
+		ShardStats local;
+
+		while (s.running) {
+			// The timeout only matters for noticing running went false
+			int count = epoll_wait(shard.epoll, events, 2, 100);
+
+			auto start = std::chrono::steady_clock::now();
+
+			for (int i = 0; i < count; i++) {
+				if (events[i].data.fd == shard.socket) {
+					receivePackets(s, shard, local);
+				}
+				else {
+					uint64_t expirations = 0;
+
+					if (read(shard.timer, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+						continue;
+					}
+
+					for (uint64_t t = 0; t < std::min(expirations, maxCatchUp); t++) {
+						tickShard(s, shard, local);
+					}
+				}
+			}
+
+			local.busy += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			{
+				std::lock_guard<std::mutex> lock(shard.statsMutex);
+				ShardStats& stats = shard.stats;
+
+				stats.matches = shard.games.size();
+				stats.ticks += local.ticks;
+				stats.joins += local.joins;
+				stats.leaves += local.leaves;
+				stats.timeouts += local.timeouts;
+				stats.packetsIn += local.packetsIn;
+				stats.packetsOut += local.packetsOut;
+				stats.bytesOut += local.bytesOut;
+				stats.fullStates += local.fullStates;
+				stats.busy += local.busy;
+				stats.tickTimes.insert(stats.tickTimes.end(), local.tickTimes.begin(), local.tickTimes.end());
+
+				local = ShardStats();
+			}
+		}
+	}
+
+	void receivePackets(Server& s, Shard& shard, ShardStats& stats) {
+		uint8_t buffers[batchSize][64];
+		sockaddr_in addresses[batchSize];
+		iovec iovs[batchSize];
+		mmsghdr messages[batchSize];
+
+		while (true) {
+			for (uint32_t i = 0; i < batchSize; i++) {
+				iovs[i].iov_base = buffers[i];
+				iovs[i].iov_len = sizeof(buffers[i]);
+				messages[i] = {};
+				messages[i].msg_hdr.msg_iov = &iovs[i];
+				messages[i].msg_hdr.msg_iovlen = 1;
+				messages[i].msg_hdr.msg_name = &addresses[i];
+				messages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+			}
+
+			int count = recvmmsg(shard.socket, messages, batchSize, 0, nullptr);
+
+			if (count <= 0) {
+				return;
+			}
+
+			for (int i = 0; i < count; i++) {
+				ClientPacket packet;
+
+				if (readClientPacket(buffers[i], messages[i].msg_len, packet)) {
+					handlePacket(s, shard, packet, addresses[i], stats);
+				}
+			}
+
+			stats.packetsIn += count;
+
+			if (count < (int)batchSize) {
+				return;
+			}
+		}
+	}
+
+	void handlePacket(Server& s, Shard& shard, const ClientPacket& packet, const sockaddr_in& from, ShardStats& stats) {
+		auto found = shard.lookup.find(packet.token);
+
+		if (found == shard.lookup.end()) {
+			if (packet.type != Message::MESSAGE_JOIN || shard.games.size() >= s.config.maxMatchesPerShard) {
+				return;
+			}
+
+			Game game;
+			game.token = packet.token;
+			game.ip = from.sin_addr.s_addr;
+			game.port = from.sin_port;
+
+			uint32_t seed = packet.token ^ (uint32_t)std::chrono::steady_clock::now().time_since_epoch().count();
+			game.events = sim::initMatch(game.match, s.config.arena, (sim::AiPlayerType)packet.aiPlayerType, seed);
+
+			found = shard.lookup.emplace(packet.token, (uint32_t)shard.games.size()).first;
+			shard.games.push_back(game);
+
+			stats.joins++;
+		}
+
+		Game& game = shard.games[found->second];
+
+		// Someone else's token, or a client that moved, which UDP can't tell apart
+		if (game.ip != from.sin_addr.s_addr || game.port != from.sin_port) {
+			return;
+		}
+
+		if (packet.type == Message::MESSAGE_LEAVE) {
+			removeGame(shard, found->second);
+			stats.leaves++;
+
+			return;
+		}
+
+		game.input = packet.input;
+		game.echo = packet.echo;
+		game.lastHeard = std::chrono::steady_clock::now();
+
+		// Packets can come out of order, an ack only moves forward
+		if (packet.ack != noTick && (game.ack == noTick || (int32_t)(packet.ack - game.ack) > 0)) {
+			game.ack = packet.ack;
+		}
+	}
+
+	void tickShard(Server& s, Shard& shard, ShardStats& stats) {
+		auto start = std::chrono::steady_clock::now();
+
+		const Config& config = s.config;
+		const float delta = 1.0f / config.tickRate;
+
+		for (Game& game : shard.games) {
+			game.events |= sim::step(game.match, game.input, delta);
+		}
+
+		shard.tick++;
+
+		if (shard.tick % config.sendInterval == 0) {
+			uint8_t buffers[batchSize][maxStatePacketSize];
+			sockaddr_in addresses[batchSize];
+			iovec iovs[batchSize];
+			mmsghdr messages[batchSize];
+			uint32_t queued = 0;
+
+			for (size_t g = 0; g < shard.games.size(); g++) {
+				Game& game = shard.games[g];
+
+				State& state = game.history[(game.match.tick / config.sendInterval) % stateHistory];
+				toState(game.match, state);
+
+				const State* base = nullptr;
+
+				if (game.ack != noTick) {
+					const State& acked = game.history[(game.ack / config.sendInterval) % stateHistory];
+
+					if (acked.tick == game.ack && acked.tick != state.tick) {
+						base = &acked;
+					}
+				}
+
+				if (!base) {
+					stats.fullStates++;
+				}
+
+				size_t size = writeState(buffers[queued], game.token, state, base, game.echo, (uint8_t)game.events);
+				game.events = sim::Event::EVENT_NONE;
+
+				addresses[queued] = {};
+				addresses[queued].sin_family = AF_INET;
+				addresses[queued].sin_addr.s_addr = game.ip;
+				addresses[queued].sin_port = game.port;
+
+				iovs[queued].iov_base = buffers[queued];
+				iovs[queued].iov_len = size;
+				messages[queued] = {};
+				messages[queued].msg_hdr.msg_iov = &iovs[queued];
+				messages[queued].msg_hdr.msg_iovlen = 1;
+				messages[queued].msg_hdr.msg_name = &addresses[queued];
+				messages[queued].msg_hdr.msg_namelen = sizeof(addresses[queued]);
+
+				stats.bytesOut += size;
+				queued++;
+
+				if (queued == batchSize || g + 1 == shard.games.size()) {
+					// A full send buffer drops the rest, the client gets the
+					// next state instead.
+					int sent = sendmmsg(shard.socket, messages, queued, 0);
+					stats.packetsOut += (sent > 0) ? sent : 0;
+					queued = 0;
+				}
+			}
+		}
+
+		// Clients that went quiet, checked once a second
+		if (shard.tick % config.tickRate == 0) {
+			auto oldest = std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+				std::chrono::duration<float>(config.timeout));
+
+			for (uint32_t g = 0; g < shard.games.size();) {
+				if (shard.games[g].lastHeard < oldest) {
+					removeGame(shard, g);
+					stats.timeouts++;
+				}
+				else {
+					g++;
+				}
+			}
+		}
+
+		stats.ticks++;
+		stats.tickTimes.push_back(std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	// Swaps the last game into its place
+	void removeGame(Shard& shard, uint32_t index) {
+		shard.lookup.erase(shard.games[index].token);
+
+		if (index + 1 != shard.games.size()) {
+			shard.games[index] = shard.games.back();
+			shard.lookup[shard.games[index].token] = index;
+		}
+
+		shard.games.pop_back();
+	}
+
+	void releaseShard(Shard& shard) {
+		if (shard.epoll >= 0) {
+			close(shard.epoll);
+			shard.epoll = -1;
+		}
+
+		if (shard.timer >= 0) {
+			close(shard.timer);
+			shard.timer = -1;
+		}
+
+		if (shard.socket >= 0) {
+			close(shard.socket);
+			shard.socket = -1;
+		}
+
+		shard.games.clear();
+		shard.lookup.clear();
+	}
+
+	void putU32(uint8_t* out, uint32_t value) {
+		for (uint32_t i = 0; i < 4; i++) {
+			out[i] = (uint8_t)(value >> (i * 8));
+		}
+	}
+
+	uint32_t getU32(const uint8_t* data) {
+		return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+#pragma once
+
+
+// Many matches at once, each against the built in AI with a client
+// somewhere on the network playing the left paddle. Every worker thread
+// owns a shard of the matches and its own UDP socket on the shared port,
+// the kernel keeps each client on one socket, so a match is only ever
+// touched by the thread that stepped it last. Clients send their input
+// every tick and get the state of their match back as the fields that
+// changed since the last state they acknowledged.
+//
+// The event loop is epoll and timerfd, the server only builds on Linux.
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <glm/glm.hpp>
+
+#include "sim.h"
+
+namespace server {
+	const uint8_t protocolVersion = 1;
+
+	// Ticks on the wire are the low 32 bits of Match::tick
+	const uint32_t noTick = UINT32_MAX;
+
+	enum Message {
+		// Client to server
+		MESSAGE_JOIN = 0,
+		MESSAGE_INPUT,
+		MESSAGE_LEAVE,
+		// Server to client
+		MESSAGE_STATE
+	};
+
+	// What a client sees of its match
+	enum Field {
+		FIELD_PLAYER_Y = 0,
+		FIELD_AI_PLAYER_Y,
+		FIELD_BALL_X,
+		FIELD_BALL_Y,
+		FIELD_BALL_VELOCITY_X,
+		FIELD_BALL_VELOCITY_Y,
+		FIELD_PLAYER_SCORE,
+		FIELD_AI_PLAYER_SCORE,
+		FIELD_COUNT
+	};
+
+	// Floats are kept as their bits, a field changed when its bits did
+	struct State {
+		uint32_t tick = noTick;
+		uint32_t fields[FIELD_COUNT] = {};
+	};
+
+	// magic 'P' 'S', version, Message, then little endian u32s: token,
+	// latest state tick received, echo, then the input and difficulty bytes.
+	const size_t clientPacketSize = 18;
+
+	struct ClientPacket {
+		Message type = Message::MESSAGE_INPUT;
+		// Picked by the client, names its match
+		uint32_t token = 0;
+		uint32_t ack = noTick;
+		// Sent back in the next state, for measuring round trips
+		uint32_t echo = 0;
+		uint8_t input = sim::Input::INPUT_NONE;
+		uint8_t aiPlayerType = sim::AiPlayerType::AI_PLAYER_EASY;
+	};
+
+	// magic 'P' 'S', version, MESSAGE_STATE, then little endian u32s: token,
+	// tick, base tick (noTick for a full state), echo, then the events since
+	// the last state, the mask of fields sent and a u32 for every one of them.
+	const size_t stateHeaderSize = 22;
+	const size_t maxStatePacketSize = stateHeaderSize + FIELD_COUNT * 4;
+
+	struct StatePacket {
+		uint32_t token = 0;
+		uint32_t tick = 0;
+		uint32_t baseTick = noTick;
+		uint32_t echo = 0;
+		uint8_t events = sim::Event::EVENT_NONE;
+		uint8_t mask = 0;
+		// The fields in the mask, in Field order
+		uint32_t fields[FIELD_COUNT] = {};
+	};
+
+	size_t writeClientPacket(uint8_t* out, const ClientPacket& packet);
+	bool readClientPacket(const uint8_t* data, size_t size, ClientPacket& packet);
+
+	void toState(const sim::Match& m, State& state);
+
+	// state as the fields that differ from base, or all of them without one
+	size_t writeState(uint8_t* out, uint32_t token, const State& state, const State* base, uint32_t echo, uint8_t events);
+	bool readState(const uint8_t* data, size_t size, StatePacket& packet);
+
+	// base has to be the state at packet.baseTick, or anything for a full one
+	void applyState(const StatePacket& packet, const State& base, State& state);
+
+	float getField(const State& state, Field field);
+
+	// Server
+	struct Config {
+		uint16_t port = 27900;
+		// 0 for one a core
+		uint32_t threads = 0;
+		uint32_t tickRate = 120;
+		// Ticks between states sent to a client
+		uint32_t sendInterval = 2;
+		// Seconds without a packet before a match is dropped
+		float timeout = 5.0f;
+		uint32_t maxMatchesPerShard = 65536;
+		glm::vec2 arena = glm::vec2(640.0f, 480.0f);
+	};
+
+	// States kept per match to send deltas against, a client acknowledging
+	// one older than this gets a full state.
+	const uint32_t stateHistory = 32;
+
+	struct Game {
+		sim::Match match;
+		uint32_t token = 0;
+		// Where the client's packets come from, in network byte order
+		uint32_t ip = 0;
+		uint16_t port = 0;
+		uint32_t input = sim::Input::INPUT_NONE;
+		uint32_t ack = noTick;
+		uint32_t echo = 0;
+		// Raised since the last state sent
+		uint32_t events = sim::Event::EVENT_NONE;
+		std::chrono::steady_clock::time_point lastHeard;
+		// States sent, the one for tick t at (t / sendInterval) % stateHistory
+		State history[stateHistory];
+	};
+
+	struct ShardStats {
+		uint64_t matches = 0;
+		uint64_t ticks = 0;
+		uint64_t joins = 0;
+		uint64_t leaves = 0;
+		uint64_t timeouts = 0;
+		uint64_t packetsIn = 0;
+		uint64_t packetsOut = 0;
+		uint64_t bytesOut = 0;
+		uint64_t fullStates = 0;
+		// Seconds spent on anything but waiting
+		double busy = 0.0;
+		// Seconds each tick took, stepping and sending every match
+		std::vector<float> tickTimes;
+	};
+
+	struct Shard {
+		int socket = -1;
+		int epoll = -1;
+		int timer = -1;
+		std::thread thread;
+
+		std::vector<Game> games;
+		// token to index in games
+		std::unordered_map<uint32_t, uint32_t> lookup;
+		uint64_t tick = 0;
+
+		// Taken by takeStats while the shard runs
+		std::mutex statsMutex;
+		ShardStats stats;
+	};
+
+	struct Server {
+		Config config;
+		std::vector<std::unique_ptr<Shard>> shards;
+		std::atomic<bool> running{ false };
+	};
+
+	// Opens a socket per shard on config.port and starts their threads,
+	// throws if any can't be set up.
+	void startServer(Server& s, const Config& config);
+	void stopServer(Server& s);
+
+	// Adds up every shard's stats since the last call and resets them
+	void takeStats(Server& s, ShardStats& total);
+}
\ No newline at end of file
@@ -0,0 +1,342 @@
+#include "sim.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace sim {
+
+	void toRect(util::Rect& r, const Paddle& pad);
+	void toRect(util::Rect& r, const Ball& ball);
+
+	void updatePaddlePlayer(Match& m, Paddle& pad, uint32_t input, float delta);
+
+	inline void updatePaddleAiWith(Match& m, Paddle& pad, AiState& state, const AiParams& params, bool left, float delta);
+
+	template<AiPlayerType T>
+	void updatePaddleAiFor(Match& m, Paddle& pad, AiState& state, bool left, float delta) {
+		updatePaddleAiWith(m, pad, state, aiParams[T], left, delta);
+	}
+
+	typedef void (*AiUpdate)(Match& m, Paddle& pad, AiState& state, bool left, float delta);
+
+	const AiUpdate aiUpdates[AiPlayerType::AI_PLAYER_COUNT] = {
+		updatePaddleAiFor<AiPlayerType::AI_PLAYER_EASY>,
+		updatePaddleAiFor<AiPlayerType::AI_PLAYER_NORMAL>,
+		updatePaddleAiFor<AiPlayerType::AI_PLAYER_HARD>,
+		updatePaddleAiFor<AiPlayerType::AI_PLAYER_EXPERT>,
+		updatePaddleAiFor<AiPlayerType::AI_PLAYER_IMPOSSIBLE>
+	};
+
+	uint32_t resetBall(Match& m, Ball& b);
+	uint32_t updateBall(Match& m, Ball& b, float delta);
+
+	uint32_t initMatch(Match& m, glm::vec2 arena, AiPlayerType type, uint32_t seed) {
+		m.arena = arena;
+		m.aiPlayerType = type;
+		m.rng = makeRng(seed);
+		m.playerScore = 0;
+		m.aiPlayerScore = 0;
+		m.tick = 0;
+		m.playerState = AiState();
+		m.aiPlayerState = AiState();
+
+		m.player.size = glm::vec2(8.0f, 64.0f);
+		m.player.position = glm::vec2(4.0f, (arena.y * 0.5f - m.player.size.y * 0.5f));
+		m.player.velocity = glm::vec2(0.0f);
+		m.player.speed = 128.0f;
+
+		m.aiPlayer.size = glm::vec2(8.0f, 64.0f);
+		m.aiPlayer.position = glm::vec2(arena.x - m.aiPlayer.size.x - 4.0f, (arena.y * 0.5f - m.aiPlayer.size.y * 0.5f));
+		m.aiPlayer.velocity = glm::vec2(0.0f);
+		m.aiPlayer.speed = 128.0f;
+
+		m.ball.size = glm::vec2(16.0f);
+		return resetBall(m, m.ball);
+	}
+
+	uint32_t step(Match& m, uint32_t input, float delta) {
+		return step(m, input, Input::INPUT_NONE, delta);
+	}
+
+	uint32_t step(Match& m, uint32_t input, uint32_t aiPlayerInput, float delta) {
+		if (m.playerAi) {
+			updatePaddleAi(m, m.player, m.playerState, m.playerType, true, delta);
+		}
+		else {
+			updatePaddlePlayer(m, m.player, input, delta);
+		}
+
+		if (m.aiPlayerHuman) {
+			updatePaddlePlayer(m, m.aiPlayer, aiPlayerInput, delta);
+		}
+		else {
+			updatePaddleAi(m, m.aiPlayer, m.aiPlayerState, m.aiPlayerType, false, delta);
+		}
+
+		uint32_t events = updateBall(m, m.ball, delta);
+
+		m.tick++;
+
+		return events;
+	}
+
+	Rng makeRng(uint32_t seed) {
+		Rng rng;
+
+		uint32_t state = seed * 0x9E3779B9u;
+		state ^= state >> 16;
+		rng.state = (state != 0) ? state : 1;
+
+		return rng;
+	}
+
+	const AiParams& getAiParams(AiPlayerType type) {
+		return aiParams[type];
+	}
+
+	float predictBallY(const Match& m, float x) {
+		const Ball& b = m.ball;
+
+		float vx = b.velocity.x * b.speed.x;
+
+		if (vx == 0.0f) {
+			return b.position.y;
+		}
+
+		float time = std::max((x - b.position.x) / vx, 0.0f);
+
+		return reflectY(b.position.y, b.velocity.y * b.speed.y, time, m.arena.y - b.size.y);
+	}
+
+	float reflectY(float y, float vy, float time, float range) {
+		if (range <= 0.0f) {
+			return 0.0f;
+		}
+
+		// Bouncing between 0 and range is the same path as moving freely and
+		// folding it back, which repeats every 2 * range.
+		float period = range * 2.0f;
+		float folded = std::fmod(y + vy * time, period);
+
+		if (folded < 0.0f) {
+			folded += period;
+		}
+
+		return (folded > range) ? period - folded : folded;
+	}
+
+	const char* toString(AiPlayerType type) {
+		switch (type) {
+		case AiPlayerType::AI_PLAYER_EASY:
+			return "easy";
+		case AiPlayerType::AI_PLAYER_NORMAL:
+			return "normal";
+		case AiPlayerType::AI_PLAYER_HARD:
+			return "hard";
+		case AiPlayerType::AI_PLAYER_EXPERT:
+			return "expert";
+		case AiPlayerType::AI_PLAYER_IMPOSSIBLE:
+			return "impossible";
+		default:
+			return "unknown";
+		}
+	}
+
+	void toRect(util::Rect& r, const Paddle& pad) {
+		r.init(pad.position, pad.size);
+	}
+	
+	void toRect(util::Rect& r, const Ball& ball) {
+		r.init(ball.position, ball.size);
+	}
+
+	void updatePaddlePlayer(Match& m, Paddle& pad, uint32_t input, float delta) {
+		if (input & Input::INPUT_UP) {
+			pad.velocity.y = -1.0f;
+
+			if (pad.position.y < 0.0f) {
+				pad.velocity.y = 0.0f;
+			}
+		}
+		else if (input & Input::INPUT_DOWN) {
+			pad.velocity.y = 1.0f;
+
+			if (pad.position.y + pad.size.y > m.arena.y) {
+				pad.velocity.y = 0.0f;
+			}
+		}
+		else {
+			pad.velocity.y = 0.0f;
+		}
+
+		pad.position += pad.velocity * pad.speed * delta;
+
+
+	}
+	
+	void updatePaddleAi(Match& m, Paddle& pad, AiState& state, const AiParams& params, bool left, float delta) {
+		updatePaddleAiWith(m, pad, state, params, left, delta);
+	}
+
+	void updatePaddleAi(Match& m, Paddle& pad, AiState& state, AiPlayerType type, bool left, float delta) {
+		aiUpdates[type](m, pad, state, left, delta);
+	}
+
+	// Inlined into every updatePaddleAiFor, where params is a constant and
+	// the noise and reaction branches fold away for the difficulties that
+	// have none.
+	inline void updatePaddleAiWith(Match& m, Paddle& pad, AiState& state, const AiParams& params, bool left, float delta) {
+		const Ball& b = m.ball;
+
+		bool towards = left ? b.velocity.x < 0.0f : b.velocity.x > 0.0f;
+
+		pad.velocity.y = 0.0f;
+
+		if (!towards) {
+			state.tracking = false;
+			return;
+		}
+
+		// Decided once per approach, the ball only changes course at the
+		// walls until it reaches the paddle and predictBallY covers those.
+		if (!state.tracking) {
+			float x = left ? pad.position.x + pad.size.x : pad.position.x - b.size.x;
+
+			state.aim = predictBallY(m, x) + b.size.y * 0.5f;
+
+			if (params.predictionNoise > 0.0f) {
+				std::normal_distribution<float> noise(0.0f, params.predictionNoise);
+				state.aim += noise(m.rng);
+			}
+
+			state.reaction = params.reactionTime;
+			state.tracking = true;
+		}
+
+		state.reaction -= delta;
+
+		float distance = left ? b.position.x + b.size.x : m.arena.x - b.position.x;
+
+		if (state.reaction > 0.0f || distance > params.activation * m.arena.x || delta <= 0.0f) {
+			return;
+		}
+
+		float maxMove = std::min(params.maxSpeed, pad.speed) * delta;
+		float move = std::clamp(state.aim - (pad.position.y + pad.size.y * 0.5f), -maxMove, maxMove);
+		float y = std::clamp(pad.position.y + move, 0.0f, m.arena.y - pad.size.y);
+
+		pad.velocity.y = (y - pad.position.y) / (pad.speed * delta);
+		pad.position.y = y;
+	}
+
+	uint32_t resetBall(Match& m, Ball& b) {
+		b.speed = glm::vec2(32.0f);
+
+		// A serve is a new approach for both paddles, the AI of the side
+		// that just conceded would otherwise keep aiming for the last ball.
+		m.playerState.tracking = false;
+		m.aiPlayerState.tracking = false;
+
+		b.position = glm::vec2(
+			m.arena.x * 0.5f - b.size.x * 0.5f,
+			m.arena.y * 0.5f - b.size.y * 0.5f
+		);
+
+		b.velocity = glm::vec2(
+			(m.rng() % 2 == 0) ? -1.0f : 1.0f,
+			(m.rng() % 2 == 0) ? -1.0f : 1.0f
+		);
+
+		return Event::EVENT_SPAWN_BALL;
+	}
+
+	// Moves the ball along its path for the whole tick and resolves every
+	// wall and paddle it meets on the way at the moment it meets it, so a
+	// fast ball or a long tick can't pass through a paddle.
+	uint32_t updateBall(Match& m, Ball& b, float delta) {
+		uint32_t events = Event::EVENT_NONE;
+
+		util::Rect p1r, p2r;
+
+		toRect(p1r, m.player);
+		toRect(p2r, m.aiPlayer);
+
+		float remaining = delta;
+
+		for (uint32_t i = 0; i < ballMaxBounces && remaining > 0.0f; i++) {
+			glm::vec2 move = b.velocity * b.speed * remaining;
+
+			// Fraction of move until the first thing the ball meets
+			float time = 1.0f;
+			uint32_t hit = Event::EVENT_NONE;
+			const Paddle* pad = nullptr;
+
+			float t;
+			glm::vec2 normal;
+
+			if (move.y < 0.0f) {
+				t = -b.position.y / move.y;
+
+				if (t < time) {
+					time = std::max(t, 0.0f);
+					hit = Event::EVENT_WALL_HIT;
+				}
+			}
+			else if (move.y > 0.0f) {
+				t = (m.arena.y - b.position.y - b.size.y) / move.y;
+
+				if (t < time) {
+					time = std::max(t, 0.0f);
+					hit = Event::EVENT_WALL_HIT;
+				}
+			}
+
+			util::Rect br;
+			toRect(br, b);
+
+			// Only a ball heading for a paddle can hit it
+			if (move.x < 0.0f && util::sweepRect(br, move, p1r, t, normal) && t < time) {
+				time = t;
+				hit = Event::EVENT_PADDLE_HIT;
+				pad = &m.player;
+			}
+
+			if (move.x > 0.0f && util::sweepRect(br, move, p2r, t, normal) && t < time) {
+				time = t;
+				hit = Event::EVENT_PADDLE_HIT;
+				pad = &m.aiPlayer;
+			}
+
+			b.position += move * time;
+			remaining -= remaining * time;
+
+			if (hit == Event::EVENT_NONE) {
+				break;
+			}
+
+			events |= hit;
+
+			if (hit == Event::EVENT_WALL_HIT) {
+				b.velocity.y = -b.velocity.y;
+			}
+			else {
+				b.velocity.x = (pad == &m.player) ? 1.0f : -1.0f;
+				b.speed.x = std::min(b.speed.x + b.speed.x * 0.1f, ballMaxSpeed);
+			}
+		}
+
+		if (b.position.x + b.size.x < 0.0f) {
+			m.aiPlayerScore++;
+			events |= Event::EVENT_AI_PLAYER_SCORE;
+			events |= resetBall(m, b);
+		}
+		else if (b.position.x > m.arena.x) {
+			m.playerScore++;
+			events |= Event::EVENT_PLAYER_SCORE;
+			events |= resetBall(m, b);
+		}
+
+		return events;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,287 @@
+#pragma once
+
+
+// The rules of the game on their own, without SDL, Vulkan or audio, so a
+// match can be stepped by the game, a tool or a server as fast as the CPU
+// allows.
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <type_traits>
+#include <functional>
+#include <glm/glm.hpp>
+
+#include "rect.h"
+#include "thread_pool.h"
+
+namespace sim {
+	enum AiPlayerType {
+		AI_PLAYER_EASY = 0,
+		AI_PLAYER_NORMAL,
+		AI_PLAYER_HARD,
+		AI_PLAYER_EXPERT,
+		AI_PLAYER_IMPOSSIBLE,
+		AI_PLAYER_COUNT
+	};
+
+	// Controls of the player's paddle for one tick
+	enum Input {
+		INPUT_NONE = 0,
+		INPUT_UP = 1 << 0,
+		INPUT_DOWN = 1 << 1
+	};
+
+	// What happened during a tick, the game plays its sounds from these
+	enum Event {
+		EVENT_NONE = 0,
+		EVENT_WALL_HIT = 1 << 0,
+		EVENT_PADDLE_HIT = 1 << 1,
+		EVENT_PLAYER_SCORE = 1 << 2,
+		EVENT_AI_PLAYER_SCORE = 1 << 3,
+		EVENT_SPAWN_BALL = 1 << 4
+	};
+
+	// Every paddle hit speeds the ball up by 10% up to this
+	const float ballMaxSpeed = 2048.0f;
+
+	// Bounces resolved in one tick before the rest of it is dropped
+	const uint32_t ballMaxBounces = 8;
+
+	// 32 bit xorshift, usable with the <random> distributions. Four bytes
+	// of state where mt19937 has kilobytes, so a Match or a Snapshot of it
+	// copies in a few cycles.
+	struct Rng {
+		typedef uint32_t result_type;
+
+		uint32_t state = 1;
+
+		// xorshift never gives 0
+		static constexpr uint32_t min() { return 1; }
+		static constexpr uint32_t max() { return UINT32_MAX; }
+
+		uint32_t operator()() {
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+	};
+
+	// Nearby seeds start out with unrelated states
+	Rng makeRng(uint32_t seed);
+
+	struct Paddle {
+		glm::vec2 position;
+		glm::vec2 size;
+		glm::vec2 velocity;
+		float speed = 32.0f;
+	};
+
+	struct Ball {
+		glm::vec2 position;
+		glm::vec2 size;
+		glm::vec2 velocity;
+		glm::vec2 speed;
+	};
+
+	// One difficulty of the AI
+	struct AiParams {
+		// Seconds from the ball turning towards the paddle until it moves
+		float reactionTime;
+		// Standard deviation, in pixels, of where it expects the ball
+		float predictionNoise;
+		// Pixels a second, never more than the paddle's own speed
+		float maxSpeed;
+		// It only moves once the ball is this fraction of the arena width
+		// or less from its side.
+		float activation;
+	};
+
+	// reaction time, prediction noise, max speed, activation of every
+	// difficulty, indexed by AiPlayerType
+	constexpr AiParams aiParams[AiPlayerType::AI_PLAYER_COUNT] = {
+		{0.4f, 40.0f, 64.0f, 0.35f},
+		{0.3f, 24.0f, 96.0f, 0.5f},
+		{0.2f, 12.0f, 128.0f, 0.75f},
+		{0.1f, 6.0f, 128.0f, 1.0f},
+		{0.0f, 0.0f, 128.0f, 1.0f}
+	};
+
+	// What an AI decided when the ball last turned towards its paddle
+	struct AiState {
+		bool tracking = false;
+		// y the paddle's center is heading for
+		float aim = 0.0f;
+		// Seconds left before it moves
+		float reaction = 0.0f;
+	};
+
+	struct Match {
+		// Width and height of the playfield, the old swapchain extent
+		glm::vec2 arena;
+
+		Paddle player;
+		Paddle aiPlayer;
+		Ball ball;
+
+		AiPlayerType aiPlayerType = AiPlayerType::AI_PLAYER_EASY;
+		AiState aiPlayerState;
+
+		// The ai player's paddle follows a second player's input instead of
+		// the AI when set, for two player matches over the network.
+		bool aiPlayerHuman = false;
+
+		// The player's paddle is played by the AI instead of input when set
+		bool playerAi = false;
+		AiPlayerType playerType = AiPlayerType::AI_PLAYER_EASY;
+		AiState playerState;
+
+		Rng rng;
+
+		uint32_t playerScore = 0;
+		uint32_t aiPlayerScore = 0;
+		uint64_t tick = 0;
+	};
+
+	// Paddles centered on their sides and the first ball served, the
+	// returned EVENT_SPAWN_BALL is the serve.
+	uint32_t initMatch(Match& m, glm::vec2 arena, AiPlayerType type, uint32_t seed);
+
+	// Advances the match by delta seconds with the player's paddle driven
+	// by input, returns the Event bits raised during the tick.
+	uint32_t step(Match& m, uint32_t input, float delta);
+
+	// The same with aiPlayerInput for the right paddle if aiPlayerHuman is set
+	uint32_t step(Match& m, uint32_t input, uint32_t aiPlayerInput, float delta);
+
+	const AiParams& getAiParams(AiPlayerType type);
+
+	// y the top of the ball will be at when its left edge reaches x. The
+	// wall bounces on the way are worked out in closed form, so it costs
+	// the same however far or fast the ball goes.
+	float predictBallY(const Match& m, float x);
+
+	// y of something at y moving at vy after time seconds, bouncing
+	// between 0 and range.
+	float reflectY(float y, float vy, float time, float range);
+
+	// One tick of the AI moving pad, the left paddle when left is set
+	void updatePaddleAi(Match& m, Paddle& pad, AiState& state, const AiParams& params, bool left, float delta);
+
+	// The same for one of the difficulties. Every difficulty has its own
+	// copy compiled with its params as constants, picked from a table by
+	// type, so a tick costs one indirect call and no lookup.
+	void updatePaddleAi(Match& m, Paddle& pad, AiState& state, AiPlayerType type, bool left, float delta);
+
+	const char* toString(AiPlayerType type);
+
+	// Snapshot
+	// Everything in a Match that a tick changes. The arena and difficulties
+	// only change from outside, whoever rolls back sets them again.
+	struct Snapshot {
+		Paddle player;
+		Paddle aiPlayer;
+		Ball ball;
+		AiState playerState;
+		AiState aiPlayerState;
+		Rng rng;
+		uint32_t playerScore;
+		uint32_t aiPlayerScore;
+		uint64_t tick;
+	};
+
+	static_assert(std::is_trivially_copyable<Snapshot>::value, "Snapshot must copy as plain bytes");
+
+	// The snapshots of the last count ticks, tick t's at t % count
+	struct SnapshotRing {
+		std::vector<Snapshot> snapshots;
+	};
+
+	void saveSnapshot(const Match& m, Snapshot& s);
+	void restoreSnapshot(Match& m, const Snapshot& s);
+
+	void initSnapshotRing(SnapshotRing& ring, uint32_t count);
+
+	// Saves m as it is before its tick m.tick is stepped
+	void pushSnapshot(SnapshotRing& ring, const Match& m);
+
+	// Puts m back to before tick was stepped, false if the ring no longer
+	// or doesn't yet hold that tick.
+	bool rewindSnapshot(SnapshotRing& ring, Match& m, uint64_t tick);
+
+	// Batch
+	// Results a lane adds up over all the matches it plays
+	struct BatchStats {
+		uint64_t playerWins = 0;
+		uint64_t aiPlayerWins = 0;
+		uint64_t points = 0;
+		uint64_t hits = 0;
+		uint64_t longestRally = 0;
+	};
+
+	// Count AI against AI matches stored as structure of arrays, so a tick
+	// walks every field front to back and the loops vectorize. Paddles
+	// only move on y and the ball's y speed never changes, so neither is
+	// stored. Each lane plays first to points matches one after another.
+	// Lanes use the same xorshift as Match but aim with a cheaper normal,
+	// so they play like Match does but not tick for tick the same,
+	// sim_check holds the two to the same points, rallies and winners.
+	struct Batch {
+		uint32_t count = 0;
+		glm::vec2 arena;
+		uint32_t points = 5;
+
+		// Paddles
+		std::vector<float> playerY;
+		std::vector<float> aiPlayerY;
+		// The AI of each paddle as in updatePaddleAi. The aim is picked
+		// whenever the ball turns towards the paddle, the tick only counts
+		// down the reaction and moves towards it. Activation is in pixels.
+		std::vector<float> playerAim;
+		std::vector<float> playerReaction;
+		std::vector<float> playerActivation;
+		std::vector<float> playerMaxSpeed;
+		std::vector<float> aiPlayerAim;
+		std::vector<float> aiPlayerReaction;
+		std::vector<float> aiPlayerActivation;
+		std::vector<float> aiPlayerMaxSpeed;
+
+		// Ball
+		std::vector<float> ballX;
+		std::vector<float> ballY;
+		std::vector<float> ballVelocityX;
+		std::vector<float> ballVelocityY;
+		std::vector<float> ballSpeedX;
+
+		// Event bits of the last tick
+		std::vector<uint32_t> events;
+		// Paddle hits since the last point
+		std::vector<uint32_t> rally;
+
+		std::vector<uint32_t> rng;
+		std::vector<AiPlayerType> playerType;
+		std::vector<AiPlayerType> aiPlayerType;
+		std::vector<uint32_t> playerScore;
+		std::vector<uint32_t> aiPlayerScore;
+		std::vector<BatchStats> stats;
+	};
+
+	void initBatch(Batch& b, uint32_t count, glm::vec2 arena, uint32_t points);
+
+	// Starts lane i over as a new match between the given difficulties
+	void setBatchMatch(Batch& b, uint32_t i, AiPlayerType player, AiPlayerType aiPlayer, uint32_t seed);
+
+	// Ticks have to be shorter than this, the batch only tests for paddles
+	// after the ball moves and a longer tick at ballMaxSpeed can carry it
+	// past a paddle and ball together. Over 85 ticks a second.
+	const float batchMaxDelta = (8.0f + 16.0f) / ballMaxSpeed;
+
+	// One tick of delta seconds for lanes [begin, end), delta under
+	// batchMaxDelta
+	void stepBatch(Batch& b, uint32_t begin, uint32_t end, float delta);
+
+	// ticks ticks for every lane, the lanes split in shards across the pool.
+	// Throws if delta isn't under batchMaxDelta.
+	void runBatch(Batch& b, util::ThreadPool& pool, uint64_t ticks, float delta);
+}
\ No newline at end of file
@@ -0,0 +1,342 @@
+#include "sim.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+
+namespace sim {
+
+	// Same sizes and speeds as initMatch
+	const float paddleWidth = 8.0f;
+	const float paddleHeight = 64.0f;
+	const float paddleMargin = 4.0f;
+	const float paddleSpeed = 128.0f;
+	const float ballSize = 16.0f;
+	const float ballSpeed = 32.0f;
+
+	// Lanes a thread steps on its own, small enough that every field of a
+	// shard stays in L2 for the whole run.
+	const uint32_t batchShardSize = 2048;
+
+	void resetBatchBall(Batch& b, uint32_t i);
+	void scoreBatch(Batch& b, uint32_t i);
+	void predictBatch(Batch& b, uint32_t i);
+	uint32_t nextBatchRandom(Batch& b, uint32_t i);
+	float nextBatchNormal(Batch& b, uint32_t i);
+
+	void initBatch(Batch& b, uint32_t count, glm::vec2 arena, uint32_t points) {
+		b.count = count;
+		b.arena = arena;
+		b.points = points;
+
+		b.playerY.assign(count, 0.0f);
+		b.aiPlayerY.assign(count, 0.0f);
+		b.playerAim.assign(count, 0.0f);
+		b.playerReaction.assign(count, 0.0f);
+		b.playerActivation.assign(count, 0.0f);
+		b.playerMaxSpeed.assign(count, 0.0f);
+		b.aiPlayerAim.assign(count, 0.0f);
+		b.aiPlayerReaction.assign(count, 0.0f);
+		b.aiPlayerActivation.assign(count, 0.0f);
+		b.aiPlayerMaxSpeed.assign(count, 0.0f);
+
+		b.ballX.assign(count, 0.0f);
+		b.ballY.assign(count, 0.0f);
+		b.ballVelocityX.assign(count, 0.0f);
+		b.ballVelocityY.assign(count, 0.0f);
+		b.ballSpeedX.assign(count, 0.0f);
+
+		b.events.assign(count, 0);
+		b.rally.assign(count, 0);
+
+		b.rng.assign(count, 1);
+		b.playerType.assign(count, AiPlayerType::AI_PLAYER_EASY);
+		b.aiPlayerType.assign(count, AiPlayerType::AI_PLAYER_EASY);
+		b.playerScore.assign(count, 0);
+		b.aiPlayerScore.assign(count, 0);
+		b.stats.assign(count, BatchStats());
+	}
+
+	void setBatchMatch(Batch& b, uint32_t i, AiPlayerType player, AiPlayerType aiPlayer, uint32_t seed) {
+		b.playerType[i] = player;
+		b.aiPlayerType[i] = aiPlayer;
+
+		const AiParams& pp = getAiParams(player);
+		b.playerActivation[i] = pp.activation * b.arena.x;
+		b.playerMaxSpeed[i] = std::min(pp.maxSpeed, paddleSpeed);
+
+		const AiParams& ap = getAiParams(aiPlayer);
+		b.aiPlayerActivation[i] = ap.activation * b.arena.x;
+		b.aiPlayerMaxSpeed[i] = std::min(ap.maxSpeed, paddleSpeed);
+
+		b.rng[i] = makeRng(seed).state;
+
+		b.playerY[i] = b.arena.y * 0.5f - paddleHeight * 0.5f;
+		b.aiPlayerY[i] = b.arena.y * 0.5f - paddleHeight * 0.5f;
+
+		b.events[i] = 0;
+		b.rally[i] = 0;
+		b.playerScore[i] = 0;
+		b.aiPlayerScore[i] = 0;
+		b.stats[i] = BatchStats();
+
+		resetBatchBall(b, i);
+	}
+
+	// Written as straight loops over one field at a time with selects in
+	// place of branches, and & rather than && so no test short circuits
+	// into a branch, so each vectorizes. Paddle hits and scoring are
+	// rare and need the RNG, so lanes only flag them here and they are
+	// handled after. Collision is tested after moving rather than swept like
+	// updateBall, which only holds while a tick can't carry the ball past a
+	// whole paddle, runBatch checks delta against batchMaxDelta for that.
+	void stepBatch(Batch& b, uint32_t begin, uint32_t end, float delta) {
+		const float width = b.arena.x;
+		const float height = b.arena.y;
+		const float top = height - paddleHeight;
+
+		float* playerY = b.playerY.data();
+		float* aiPlayerY = b.aiPlayerY.data();
+		const float* playerAim = b.playerAim.data();
+		float* playerReaction = b.playerReaction.data();
+		const float* playerActivation = b.playerActivation.data();
+		const float* playerMaxSpeed = b.playerMaxSpeed.data();
+		const float* aiPlayerAim = b.aiPlayerAim.data();
+		float* aiPlayerReaction = b.aiPlayerReaction.data();
+		const float* aiPlayerActivation = b.aiPlayerActivation.data();
+		const float* aiPlayerMaxSpeed = b.aiPlayerMaxSpeed.data();
+		float* ballX = b.ballX.data();
+		float* ballY = b.ballY.data();
+		float* ballVelocityX = b.ballVelocityX.data();
+		float* ballVelocityY = b.ballVelocityY.data();
+		float* ballSpeedX = b.ballSpeedX.data();
+		uint32_t* events = b.events.data();
+
+		// Kept apart from the paddle loops, with a second store in them GCC
+		// gives up on proving the arrays don't overlap and won't vectorize.
+		for (uint32_t i = begin; i < end; i++) {
+			playerReaction[i] -= delta;
+			aiPlayerReaction[i] -= delta;
+		}
+
+		// Paddles, the player's on the left
+		for (uint32_t i = begin; i < end; i++) {
+			float y = playerY[i];
+			float reaction = playerReaction[i];
+			float maxMove = playerMaxSpeed[i] * delta;
+
+			float move = playerAim[i] - (y + paddleHeight * 0.5f);
+			move = (move < -maxMove) ? -maxMove : move;
+			move = (move > maxMove) ? maxMove : move;
+
+			// Only once the ball heads this way, the reaction is over and the
+			// ball is close enough
+			move = ballVelocityX[i] < 0.0f ? move : 0.0f;
+			move = (reaction <= 0.0f) ? move : 0.0f;
+			move = (ballX[i] + ballSize <= playerActivation[i]) ? move : 0.0f;
+
+			y += move;
+			y = (y < 0.0f) ? 0.0f : y;
+			playerY[i] = (y > top) ? top : y;
+		}
+
+		for (uint32_t i = begin; i < end; i++) {
+			float y = aiPlayerY[i];
+			float reaction = aiPlayerReaction[i];
+			float maxMove = aiPlayerMaxSpeed[i] * delta;
+
+			float move = aiPlayerAim[i] - (y + paddleHeight * 0.5f);
+			move = (move < -maxMove) ? -maxMove : move;
+			move = (move > maxMove) ? maxMove : move;
+
+			// Only once the ball heads this way, the reaction is over and the
+			// ball is close enough
+			move = ballVelocityX[i] > 0.0f ? move : 0.0f;
+			move = (reaction <= 0.0f) ? move : 0.0f;
+			move = (width - ballX[i] <= aiPlayerActivation[i]) ? move : 0.0f;
+
+			y += move;
+			y = (y < 0.0f) ? 0.0f : y;
+			aiPlayerY[i] = (y > top) ? top : y;
+		}
+
+		// Walls and movement
+		for (uint32_t i = begin; i < end; i++) {
+			float y = ballY[i];
+			float vy = ballVelocityY[i];
+
+			vy = (y < 0.0f) ? 1.0f : vy;
+			vy = (y + ballSize > height) ? -1.0f : vy;
+
+			ballVelocityY[i] = vy;
+			ballX[i] += ballVelocityX[i] * ballSpeedX[i] * delta;
+			ballY[i] = y + vy * ballSpeed * delta;
+		}
+
+		// Goals and paddles, a ball that scored can't hit a paddle
+		const float playerLeft = paddleMargin;
+		const float aiPlayerLeft = width - paddleWidth - paddleMargin;
+
+		for (uint32_t i = begin; i < end; i++) {
+			float x = ballX[i];
+			float y = ballY[i];
+			float vx = ballVelocityX[i];
+
+			// Comparisons as 0/1 ints rather than && so the loop stays branch
+			// free. Only a ball heading for a paddle can hit it, as in
+			// updateBall, one that just bounced off is still inside it.
+			uint32_t hit =
+				(uint32_t)(vx < 0.0f) &
+				(uint32_t)(x < playerLeft + paddleWidth) &
+				(uint32_t)(x + ballSize > playerLeft) &
+				(uint32_t)(y < playerY[i] + paddleHeight) &
+				(uint32_t)(y + ballSize > playerY[i]);
+
+			uint32_t aiHit =
+				(uint32_t)(vx > 0.0f) &
+				(uint32_t)(x < aiPlayerLeft + paddleWidth) &
+				(uint32_t)(x + ballSize > aiPlayerLeft) &
+				(uint32_t)(y < aiPlayerY[i] + paddleHeight) &
+				(uint32_t)(y + ballSize > aiPlayerY[i]);
+
+			uint32_t playerScore = (uint32_t)(x > width);
+			uint32_t aiPlayerScore = (uint32_t)(x + ballSize < 0.0f);
+			uint32_t scored = playerScore | aiPlayerScore;
+
+			uint32_t e = (hit | aiHit) * (scored ^ 1) * Event::EVENT_PADDLE_HIT;
+			e |= playerScore * Event::EVENT_PLAYER_SCORE;
+			e |= aiPlayerScore * Event::EVENT_AI_PLAYER_SCORE;
+
+			events[i] = e;
+		}
+
+		// Only one paddle can be hit at a time, the ball's side says which
+		for (uint32_t i = begin; i < end; i++) {
+			bool hit = events[i] == Event::EVENT_PADDLE_HIT;
+			float speed = ballSpeedX[i] * 1.1f;
+
+			speed = (speed > ballMaxSpeed) ? ballMaxSpeed : speed;
+
+			ballVelocityX[i] = hit ? ((ballX[i] < width * 0.5f) ? 1.0f : -1.0f) : ballVelocityX[i];
+			ballSpeedX[i] = hit ? speed : ballSpeedX[i];
+		}
+
+		for (uint32_t i = begin; i < end; i++) {
+			if (events[i] & (Event::EVENT_PLAYER_SCORE | Event::EVENT_AI_PLAYER_SCORE)) {
+				scoreBatch(b, i);
+			}
+			else if (events[i] & Event::EVENT_PADDLE_HIT) {
+				b.rally[i]++;
+				predictBatch(b, i);
+			}
+		}
+	}
+
+	void runBatch(Batch& b, util::ThreadPool& pool, uint64_t ticks, float delta) {
+		if (!(delta < batchMaxDelta)) {
+			throw std::runtime_error("batch tick of " + std::to_string(delta) + " seconds can carry the ball through a paddle");
+		}
+
+		uint32_t shards = (b.count + batchShardSize - 1) / batchShardSize;
+
+		util::parallelFor(pool, shards, [&](uint32_t shard, uint32_t) {
+			uint32_t begin = shard * batchShardSize;
+			uint32_t end = std::min(begin + batchShardSize, b.count);
+
+			// Lanes never interact, so a shard runs all of its ticks while
+			// it is hot in this core's cache.
+			for (uint64_t t = 0; t < ticks; t++) {
+				stepBatch(b, begin, end, delta);
+			}
+		});
+	}
+
+	void resetBatchBall(Batch& b, uint32_t i) {
+		uint32_t r = nextBatchRandom(b, i);
+
+		b.ballSpeedX[i] = ballSpeed;
+		b.ballX[i] = b.arena.x * 0.5f - ballSize * 0.5f;
+		b.ballY[i] = b.arena.y * 0.5f - ballSize * 0.5f;
+		b.ballVelocityX[i] = (r & 1) ? -1.0f : 1.0f;
+		b.ballVelocityY[i] = (r & 2) ? -1.0f : 1.0f;
+
+		predictBatch(b, i);
+	}
+
+	void scoreBatch(Batch& b, uint32_t i) {
+		BatchStats& stats = b.stats[i];
+
+		if (b.events[i] & Event::EVENT_PLAYER_SCORE) {
+			b.playerScore[i]++;
+		}
+		else {
+			b.aiPlayerScore[i]++;
+		}
+
+		stats.points++;
+		stats.hits += b.rally[i];
+		stats.longestRally = std::max(stats.longestRally, (uint64_t)b.rally[i]);
+
+		b.rally[i] = 0;
+
+		if (b.playerScore[i] >= b.points || b.aiPlayerScore[i] >= b.points) {
+			if (b.playerScore[i] > b.aiPlayerScore[i]) {
+				stats.playerWins++;
+			}
+			else {
+				stats.aiPlayerWins++;
+			}
+
+			b.playerScore[i] = 0;
+			b.aiPlayerScore[i] = 0;
+		}
+
+		resetBatchBall(b, i);
+	}
+
+	// Rng::operator() on a lane's state
+	uint32_t nextBatchRandom(Batch& b, uint32_t i) {
+		uint32_t x = b.rng[i];
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		b.rng[i] = x;
+		return x;
+	}
+
+	// The ball just turned towards a paddle, that paddle's AI picks where
+	// to go the way updatePaddleAi does.
+	void predictBatch(Batch& b, uint32_t i) {
+		bool left = b.ballVelocityX[i] < 0.0f;
+
+		float x = left ? paddleMargin + paddleWidth : b.arena.x - paddleMargin - paddleWidth - ballSize;
+		float time = std::max((x - b.ballX[i]) / (b.ballVelocityX[i] * b.ballSpeedX[i]), 0.0f);
+		float aim = reflectY(b.ballY[i], b.ballVelocityY[i] * ballSpeed, time, b.arena.y - ballSize) + ballSize * 0.5f;
+
+		const AiParams& params = getAiParams(left ? b.playerType[i] : b.aiPlayerType[i]);
+
+		aim += nextBatchNormal(b, i) * params.predictionNoise;
+
+		if (left) {
+			b.playerAim[i] = aim;
+			b.playerReaction[i] = params.reactionTime;
+		}
+		else {
+			b.aiPlayerAim[i] = aim;
+			b.aiPlayerReaction[i] = params.reactionTime;
+		}
+	}
+
+	// Close enough to a normal distribution for aiming, the sum of four
+	// uniforms scaled to a standard deviation of 1.
+	float nextBatchNormal(Batch& b, uint32_t i) {
+		float sum = 0.0f;
+
+		for (uint32_t n = 0; n < 4; n++) {
+			sum += (nextBatchRandom(b, i) >> 8) * (1.0f / 16777216.0f);
+		}
+
+		return (sum - 2.0f) * 1.7320508f;
+	}
+}
\ No newline at end of file
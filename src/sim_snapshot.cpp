@@ -0,0 +1,58 @@
+#include "sim.h"
+
+#include <algorithm>
+
+
+namespace sim {
+
+	// Never the tick of a saved snapshot, marks empty slots
+	const uint64_t noSnapshot = UINT64_MAX;
+
+	void saveSnapshot(const Match& m, Snapshot& s) {
+		s.player = m.player;
+		s.aiPlayer = m.aiPlayer;
+		s.ball = m.ball;
+		s.playerState = m.playerState;
+		s.aiPlayerState = m.aiPlayerState;
+		s.rng = m.rng;
+		s.playerScore = m.playerScore;
+		s.aiPlayerScore = m.aiPlayerScore;
+		s.tick = m.tick;
+	}
+
+	void restoreSnapshot(Match& m, const Snapshot& s) {
+		m.player = s.player;
+		m.aiPlayer = s.aiPlayer;
+		m.ball = s.ball;
+		m.playerState = s.playerState;
+		m.aiPlayerState = s.aiPlayerState;
+		m.rng = s.rng;
+		m.playerScore = s.playerScore;
+		m.aiPlayerScore = s.aiPlayerScore;
+		m.tick = s.tick;
+	}
+
+	void initSnapshotRing(SnapshotRing& ring, uint32_t count) {
+		ring.snapshots.assign(std::max(count, 1u), Snapshot());
+
+		for (auto& s : ring.snapshots) {
+			s.tick = noSnapshot;
+		}
+	}
+
+	void pushSnapshot(SnapshotRing& ring, const Match& m) {
+		saveSnapshot(m, ring.snapshots[m.tick % ring.snapshots.size()]);
+	}
+
+	bool rewindSnapshot(SnapshotRing& ring, Match& m, uint64_t tick) {
+		const Snapshot& s = ring.snapshots[tick % ring.snapshots.size()];
+
+		if (s.tick != tick) {
+			return false;
+		}
+
+		restoreSnapshot(m, s);
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "spatial_hash.h"
+
+#include <cmath>
+#include <algorithm>
+
+
+namespace util {
+
+	uint64_t toCellKey(int32_t x, int32_t y) {
+		return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+	}
+
+	int32_t toCell(SpatialHash& hash, float v) {
+		return (int32_t)std::floor(v / hash.cellSize);
+	}
+
+	CellRange toCellRange(SpatialHash& hash, uint32_t id) {
+		CellRange r;
+		r.minX = toCell(hash, hash.boxes.minX[id]);
+		r.minY = toCell(hash, hash.boxes.minY[id]);
+		r.maxX = toCell(hash, hash.boxes.maxX[id]);
+		r.maxY = toCell(hash, hash.boxes.maxY[id]);
+		return r;
+	}
+
+	uint32_t toSlot(SpatialHash& hash, uint64_t key) {
+		// Neighbouring cells differ in only a few bits, spread them out
+		return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (uint32_t)(hash.slots.size() - 1);
+	}
+
+	void growSlots(SpatialHash& hash) {
+		size_t size = std::max(hash.slots.size() * 2, (size_t)1024);
+
+		hash.slotKeys.assign(size, 0);
+		hash.slots.assign(size, 0);
+
+		for (uint32_t i = 0; i < hash.cells.size(); i++) {
+			uint32_t slot = toSlot(hash, hash.cells[i].key);
+
+			while (hash.slots[slot] != 0) {
+				slot = (slot + 1) & (size - 1);
+			}
+
+			hash.slotKeys[slot] = hash.cells[i].key;
+			hash.slots[slot] = i + 1;
+		}
+	}
+
+	// Returns the cell, creating it if it's the first time it's used
+	Cell& findCell(SpatialHash& hash, int32_t x, int32_t y) {
+		if ((hash.cells.size() + 1) * 2 > hash.slots.size()) {
+			growSlots(hash);
+		}
+
+		uint64_t key = toCellKey(x, y);
+		uint32_t slot = toSlot(hash, key);
+
+		while (hash.slots[slot] != 0) {
+			if (hash.slotKeys[slot] == key) {
+				return hash.cells[hash.slots[slot] - 1];
+			}
+
+			slot = (slot + 1) & (hash.slots.size() - 1);
+		}
+
+		hash.cells.push_back(Cell());
+		hash.cells.back().key = key;
+
+		hash.slotKeys[slot] = key;
+		hash.slots[slot] = hash.cells.size();
+
+		return hash.cells.back();
+	}
+
+	void insertCells(SpatialHash& hash, uint32_t id, const CellRange& r) {
+		for (int32_t y = r.minY; y <= r.maxY; y++) {
+			for (int32_t x = r.minX; x <= r.maxX; x++) {
+				findCell(hash, x, y).ids.push_back(id);
+			}
+		}
+	}
+
+	void eraseCells(SpatialHash& hash, uint32_t id, const CellRange& r) {
+		for (int32_t y = r.minY; y <= r.maxY; y++) {
+			for (int32_t x = r.minX; x <= r.maxX; x++) {
+				// Order in a cell doesn't matter, swap with the last
+				std::vector<uint32_t>& cell = findCell(hash, x, y).ids;
+				auto found = std::find(cell.begin(), cell.end(), id);
+
+				if (found != cell.end()) {
+					*found = cell.back();
+					cell.pop_back();
+				}
+			}
+		}
+	}
+}
+
+void util::initSpatialHash(SpatialHash& hash, float cellSize) {
+	hash.cellSize = cellSize;
+	clearBoxes(hash.boxes);
+	hash.ranges.clear();
+	hash.freeIds.clear();
+	hash.cells.clear();
+	hash.slotKeys.clear();
+	hash.slots.clear();
+	hash.cellMoves = 0;
+}
+
+uint32_t util::addObject(SpatialHash& hash, glm::vec2 position, glm::vec2 size) {
+	uint32_t id;
+
+	if (!hash.freeIds.empty()) {
+		id = hash.freeIds.back();
+		hash.freeIds.pop_back();
+
+		hash.boxes.minX[id] = position.x;
+		hash.boxes.minY[id] = position.y;
+		hash.boxes.maxX[id] = position.x + size.x;
+		hash.boxes.maxY[id] = position.y + size.y;
+	}
+	else {
+		id = getBoxCount(hash.boxes);
+
+		addBox(hash.boxes, position, size);
+		hash.ranges.push_back(CellRange());
+	}
+
+	hash.ranges[id] = toCellRange(hash, id);
+	insertCells(hash, id, hash.ranges[id]);
+
+	return id;
+}
+
+void util::removeObject(SpatialHash& hash, uint32_t id) {
+	eraseCells(hash, id, hash.ranges[id]);
+
+	hash.ranges[id] = CellRange();
+	hash.freeIds.push_back(id);
+}
+
+void util::moveObject(SpatialHash& hash, uint32_t id, glm::vec2 position) {
+	Boxes& b = hash.boxes;
+
+	float width = b.maxX[id] - b.minX[id];
+	float height = b.maxY[id] - b.minY[id];
+
+	b.minX[id] = position.x;
+	b.minY[id] = position.y;
+	b.maxX[id] = position.x + width;
+	b.maxY[id] = position.y + height;
+
+	CellRange now = toCellRange(hash, id);
+	CellRange& was = hash.ranges[id];
+
+	if (now.minX == was.minX && now.minY == was.minY && now.maxX == was.maxX && now.maxY == was.maxY) {
+		return;
+	}
+
+	eraseCells(hash, id, was);
+	insertCells(hash, id, now);
+
+	was = now;
+	hash.cellMoves++;
+}
+
+void util::findPairs(SpatialHash& hash, std::vector<std::pair<uint32_t, uint32_t>>& pairs) {
+	const Boxes& b = hash.boxes;
+
+	for (const Cell& entry : hash.cells) {
+		const std::vector<uint32_t>& cell = entry.ids;
+
+		if (cell.size() < 2) {
+			continue;
+		}
+
+		int32_t cellX = (int32_t)(uint32_t)(entry.key >> 32);
+		int32_t cellY = (int32_t)(uint32_t)entry.key;
+
+		for (size_t i = 0; i < cell.size(); i++) {
+			uint32_t a = cell[i];
+
+			for (size_t j = i + 1; j < cell.size(); j++) {
+				uint32_t c = cell[j];
+
+				bool overlap =
+					b.minX[a] < b.maxX[c] &&
+					b.maxX[a] > b.minX[c] &&
+					b.minY[a] < b.maxY[c] &&
+					b.maxY[a] > b.minY[c];
+
+				if (!overlap) {
+					continue;
+				}
+
+				// A pair sharing several cells is only reported by the one
+				// holding the corner of their overlap, so no set is needed.
+				float cornerX = std::max(b.minX[a], b.minX[c]);
+				float cornerY = std::max(b.minY[a], b.minY[c]);
+
+				if (toCell(hash, cornerX) != cellX || toCell(hash, cornerY) != cellY) {
+					continue;
+				}
+
+				pairs.push_back(std::make_pair(std::min(a, c), std::max(a, c)));
+			}
+		}
+	}
+
+	hash.cellMoves = 0;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <glm/glm.hpp>
+
+#include "rect.h"
+
+namespace util {
+	// Cells an object covers, inclusive. Empty (minX > maxX) once removed.
+	struct CellRange {
+		int32_t minX = 1;
+		int32_t minY = 1;
+		int32_t maxX = 0;
+		int32_t maxY = 0;
+	};
+
+	struct Cell {
+		uint64_t key;
+		std::vector<uint32_t> ids;
+	};
+
+	// Broadphase over a uniform grid of cellSize cells, looked up by hash so
+	// only cells that were used cost memory and the world has no bounds.
+	// Objects remember the cells they cover, so moving one only touches the
+	// grid when it crosses into different cells. Works best with cells
+	// about twice the size of the larger objects.
+	struct SpatialHash {
+		float cellSize = 64.0f;
+
+		// Indexed by object id
+		Boxes boxes;
+		std::vector<CellRange> ranges;
+		std::vector<uint32_t> freeIds;
+
+		// Every cell used so far, packed so findPairs reads them in order.
+		// Cells are never removed, an emptied one is usually entered again.
+		std::vector<Cell> cells;
+
+		// Open addressing from cell key to cells index + 1, 0 is empty.
+		// A power of two in size and never more than half full.
+		std::vector<uint64_t> slotKeys;
+		std::vector<uint32_t> slots;
+
+		// Objects that changed cells since the last findPairs
+		uint32_t cellMoves = 0;
+	};
+
+	void initSpatialHash(SpatialHash& hash, float cellSize);
+
+	// Returns the object's id, ids of removed objects are given out again
+	uint32_t addObject(SpatialHash& hash, glm::vec2 position, glm::vec2 size);
+	void removeObject(SpatialHash& hash, uint32_t id);
+	void moveObject(SpatialHash& hash, uint32_t id, glm::vec2 position);
+
+	// Appends every pair of objects whose boxes overlap, each pair once with
+	// the lower id first, for the narrowphase to test their real shapes.
+	void findPairs(SpatialHash& hash, std::vector<std::pair<uint32_t, uint32_t>>& pairs);
+}
\ No newline at end of file
@@ -14,6 +14,10 @@
 #include <chrono>
 #include <optional>
 #include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 // 3rd Party Libraries
 #include <SDL/SDL.h>
@@ -27,6 +31,12 @@
 #define NOMINMAX
 #include <vulkan/vulkan.h>
 
+// Game
+#include "thread_pool.h"
+#include "sim.h"
+#include "replay.h"
+#include "net.h"
+
 namespace app {
 
 	struct Config {
@@ -40,6 +50,24 @@ namespace app {
 		std::function<void()> renderCB;
 		std::function<void()> postUpdate;
 		std::function<void()> releaseCB;
+
+		// No window, the frame loop runs frames times with a fixed delta
+		bool headless = false;
+		uint32_t frames = 0;
+
+		// Frame Pacing
+		// With a target frame time the loop sleeps until the next frame is
+		// due, then calls waitFrameCB to block on the GPU, and only then
+		// polls input, so input is as fresh as possible when recorded.
+		float targetFrameTime = 0.0f; // seconds, 0 runs unpaced
+		std::function<void()> waitFrameCB;
+
+		// Fixed Timestep
+		// updateCB runs tickRate times per second of real time with a delta
+		// of exactly 1 / tickRate, renderCB draws getAlpha() of the way from
+		// the previous tick to the latest. 0 runs one variable delta update
+		// per frame.
+		float tickRate = 0.0f;
 	};
 
 	void init(Config* config);
@@ -54,6 +82,9 @@ namespace app {
 
 	SDL_Window* getWindow();
 
+	// How far real time is past the latest tick, in ticks [0, 1)
+	float getAlpha();
+
 	void exit();
 }
 
@@ -402,27 +433,85 @@ namespace util {
 	void loadFile(std::string path, std::function<void(std::string)> cb);
 	void strSplit(std::string str, char delim, std::function<void(std::string)> cb);
 
+	// Throws if the file can't be opened
 	void loadBlob(std::string path, std::vector<char>& data);
 
 	glm::vec3 toVec3(std::string str);
 	glm::vec2 toVec2(std::string str);
+}
+
+namespace vk {
+	// A range handed out by the memory allocator. mapped is only set for
+	// host visible memory, which stays mapped for the block's lifetime.
+	struct MemoryAllocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		uint8_t* mapped = nullptr;
+		uint32_t memoryType = 0;
+		uint32_t pool = 0;
+		uint32_t block = 0;
+	};
+
+	// One vkAllocateMemory, carved up with a free list of offset -> size.
+	struct MemoryBlock {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		VkDeviceSize used = 0;
+		uint8_t* mapped = nullptr;
+		uint32_t allocationCount = 0;
+		std::map<VkDeviceSize, VkDeviceSize> freeList;
+	};
 
-	struct Rect {
-		glm::vec2 position;
-		glm::vec2 size;
+	struct MemoryAllocator {
+		VkPhysicalDeviceMemoryProperties memProps;
+		VkDeviceSize blockSize = 64 * 1024 * 1024;
+		uint32_t maxAllocationCount = 0;
+		uint32_t allocationCount = 0;
+		// Buffers and optimally tiled images are kept in separate pools per
+		// memory type so bufferImageGranularity never has to be honored.
+		// Index = memoryType * 2 + (linear ? 0 : 1)
+		std::vector<std::vector<MemoryBlock>> pools;
+	};
 
-		void init(glm::vec2 p, glm::vec2 s);
+	// A single transfer submission. Copies are staged into the batch's own
+	// mapped buffer and recorded into its command buffer until it is
+	// submitted, after which its fence and semaphore report completion.
+	struct UploadBatch {
+		VkCommandBuffer commandBuffer;
+		VkFence fence;
+		VkSemaphore semaphore;
+		VkBuffer stageBuffer;
+		MemoryAllocation stageMemory;
+		uint8_t* stageData = nullptr;
+		VkDeviceSize stageSize = 0;
+		VkDeviceSize stageUsed = 0;
+		bool recording = false;
+		bool submitted = false;
+		bool semaphoreTaken = false;
+	};
 
-		float left();
-		float right();
-		float top();
-		float bottom();
+	struct Uploader {
+		VkCommandPool commandPool;
+		std::vector<UploadBatch> batches;
+		std::optional<size_t> current;
+		// Queue families that share buffers written by the uploader
+		std::vector<uint32_t> familyIndices;
+	};
 
-		bool isCollide(Rect& r);
+	// One range of timestamp queries per swapchain image, reset and written
+	// by that image's command buffer and read back when the image comes
+	// around again.
+	struct Timestamps {
+		VkQueryPool pool = VK_NULL_HANDLE;
+		uint32_t queriesPerImage = 0;
+		float period = 0.0f; // nanoseconds per tick
+		uint64_t mask = 0;
+		bool enabled = false;
+		std::vector<bool> submitted;
+		std::vector<uint64_t> results;
 	};
-}
 
-namespace vk {
 	struct Vulkan {
 		// Instance
 		VkInstance instance;
@@ -433,8 +522,13 @@ namespace vk {
 			"VK_LAYER_KHRONOS_validation"
 		};
 		std::ofstream debug;
+		// Headless
+		// Renders into offscreen images standing in for the swapchain, so
+		// no surface, present queue or swapchain extension is needed.
+		bool headless = false;
+		std::vector<MemoryAllocation> offscreenMemory;
 		// Surface
-		VkSurfaceKHR surface;
+		VkSurfaceKHR surface = VK_NULL_HANDLE;
 		// Physical Device
 		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
 		// Device
@@ -445,8 +539,11 @@ namespace vk {
 		// Queue
 		VkQueue graphicsQueue;
 		VkQueue presentQueue;
+		VkQueue transferQueue;
+		uint32_t graphicsFamily;
+		uint32_t transferFamily;
 		// Swapchain
-		VkSwapchainKHR swapchain;
+		VkSwapchainKHR swapchain = VK_NULL_HANDLE;
 		std::vector<VkImage> swapchainImages;
 		VkFormat swapchainImageFormat;
 		VkExtent2D swapchainExtent;
@@ -457,19 +554,100 @@ namespace vk {
 		std::vector<VkFramebuffer> framebuffer;
 		// Command Pool
 		VkCommandPool commandPool;
+		// Frames
+		// How many frames the CPU may record ahead of the GPU, independent
+		// of the image count. 1 gives the lowest latency, more give the
+		// GPU a deeper queue to keep it busy.
+		uint32_t framesInFlight = 2;
+		// Used when the surface supports it, FIFO otherwise
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+		uint32_t currentFrame = 0;
+		uint32_t currentImage = 0;
+		bool swapchainOutOfDate = false;
 		// Semaphores
-		std::vector<VkSemaphore> submitCB;
-		std::vector<VkSemaphore> submitPresentQueue;
+		std::vector<VkSemaphore> submitCB; // per frame, image acquired
+		std::vector<VkSemaphore> submitPresentQueue; // per image, ready to present
 		// Fence
-		std::vector<VkFence> inFlight;
-		std::vector<VkFence> imageInFlight;
+		std::vector<VkFence> inFlight; // per frame
+		std::vector<VkFence> imageInFlight; // per image, the inFlight fence of the frame using it
+		// Memory
+		MemoryAllocator allocator;
+		// Uploads
+		Uploader uploader;
+		// Timestamps
+		Timestamps timestamps;
+		// Pipeline Cache
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+		bool pipelineCacheLoaded = false;
 	};
 
 
 	void initVulkan(Vulkan& vulkan);
 	void releaseVulkan(Vulkan& vulkan);
+	// Rebuilds the swapchain, its image views and the framebuffers at the
+	// surface's current size. A new format also gets a new render pass, a
+	// new image count new per image semaphores, fences and timestamp
+	// queries. Pipelines, and whatever the caller keeps per image, are the
+	// caller's to rebuild. Returns false without touching anything while
+	// the window is minimized.
+	bool recreateSwapchain(Vulkan& vulkan);
+
+	// Frames
+	// Waits for the current frame slot and acquires an image into
+	// currentImage. Returns false when there is nothing to draw to and the
+	// frame should be skipped.
+	bool beginFrame(Vulkan& v);
+	// Waits until the current frame slot is free, which beginFrame would
+	// otherwise do itself.
+	void waitFrame(Vulkan& v);
+	// Submits cb for currentImage, after waitSemaphores and the acquire,
+	// presents it and moves on to the next frame slot.
+	void endFrame(Vulkan& v, VkCommandBuffer cb, std::vector<VkSemaphore>& waitSemaphores, std::vector<VkPipelineStageFlags>& waitStages);
+	// Waits for every frame in flight
+	void waitFrames(Vulkan& v);
+
+	// Timestamps
+	void initTimestamps(Vulkan& v, uint32_t queriesPerImage);
+	void releaseTimestamps(Vulkan& v);
+	// Must be recorded outside a render pass, before the image's first write
+	void resetTimestamps(Vulkan& v, VkCommandBuffer cb, uint32_t image);
+	void writeTimestamp(Vulkan& v, VkCommandBuffer cb, uint32_t image, uint32_t query, VkPipelineStageFlagBits stage);
+	// Milliseconds of every query since the image's first, false when the
+	// results aren't there (yet) and nothing was written to ms.
+	bool readTimestamps(Vulkan& v, uint32_t image, std::vector<double>& ms);
 
 	VkShaderModule createShaderModule(Vulkan& v, const std::vector<char>& code);
+
+	// Memory
+	void initAllocator(Vulkan& v);
+	void releaseAllocator(Vulkan& v);
+	// First memory type allowed by typeBits that has all of props
+	uint32_t findMemoryType(Vulkan& v, uint32_t typeBits, VkMemoryPropertyFlags props);
+	MemoryAllocation allocateMemory(Vulkan& v, const VkMemoryRequirements& req, VkMemoryPropertyFlags props, bool linear = true);
+	void freeMemory(Vulkan& v, MemoryAllocation& allocation);
+	// Allocates memory for the buffer and binds it
+	MemoryAllocation allocateBuffer(Vulkan& v, VkBuffer buffer, VkMemoryPropertyFlags props);
+	// Allocates memory for an optimal tiling image and binds it
+	MemoryAllocation allocateImage(Vulkan& v, VkImage image, VkMemoryPropertyFlags props);
+	void reportMemory(Vulkan& v);
+
+	// Pipeline Cache
+	// Loaded from disk at init when it was written by the same device and
+	// driver, saved back at release.
+	void initPipelineCache(Vulkan& v);
+	void releasePipelineCache(Vulkan& v);
+
+	// Uploads
+	void initUploader(Vulkan& v);
+	void releaseUploader(Vulkan& v);
+	// Buffers filled by the uploader must be created with this so they can
+	// be written on the transfer queue and read on the graphics queue.
+	void shareWithTransfer(Vulkan& v, VkBufferCreateInfo& CI);
+	void uploadBuffer(Vulkan& v, VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+	void submitUploads(Vulkan& v);
+	// Semaphores the next graphics submission must wait on
+	void takeUploadSemaphores(Vulkan& v, std::vector<VkSemaphore>& semaphores);
+	void waitUploads(Vulkan& v);
 }
 
 namespace audio {
@@ -0,0 +1,132 @@
+#include "thread_pool.h"
+
+#include <iostream>
+
+
+namespace util {
+
+	void runJobs(ThreadPool& pool, uint32_t thread) {
+		while (true) {
+			uint32_t index = pool.nextIndex++;
+
+			if (index >= pool.jobCount) {
+				break;
+			}
+
+			try {
+				pool.job(index, thread);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(pool.mutex);
+
+				if (!pool.error) {
+					pool.error = std::current_exception();
+				}
+
+				// The indices left are skipped
+				pool.nextIndex = pool.jobCount;
+			}
+		}
+	}
+
+	void workerLoop(ThreadPool& pool, uint32_t thread) {
+		uint64_t seen = 0;
+
+		while (true) {
+			std::unique_lock<std::mutex> lock(pool.mutex);
+
+			pool.wake.wait(lock, [&]() { return pool.quit || pool.generation != seen; });
+
+			if (pool.quit) {
+				return;
+			}
+
+			seen = pool.generation;
+			pool.active++;
+
+			lock.unlock();
+
+			runJobs(pool, thread);
+
+			lock.lock();
+
+			pool.active--;
+
+			if (pool.active == 0) {
+				pool.done.notify_all();
+			}
+		}
+	}
+}
+
+void util::initThreadPool(ThreadPool& pool, uint32_t threadCount) {
+	pool.quit = false;
+	pool.generation = 0;
+	pool.active = 0;
+	pool.jobCount = 0;
+	pool.nextIndex = 0;
+
+	for (uint32_t i = 0; i < threadCount; i++) {
+		pool.threads.push_back(std::thread(workerLoop, std::ref(pool), i + 1));
+	}
+
+	std::cout << "Success: Create Thread Pool (" << threadCount << " workers)" << std::endl;
+}
+
+void util::releaseThreadPool(ThreadPool& pool) {
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pool.quit = true;
+	}
+
+	pool.wake.notify_all();
+
+	for (auto& t : pool.threads) {
+		t.join();
+	}
+
+	pool.threads.clear();
+}
+
+uint32_t util::getThreadCount(ThreadPool& pool) {
+	return pool.threads.size() + 1;
+}
+
+void util::parallelFor(ThreadPool& pool, uint32_t count, std::function<void(uint32_t, uint32_t)> job) {
+	if (pool.threads.empty() || count <= 1) {
+		for (uint32_t i = 0; i < count; i++) {
+			job(i, 0);
+		}
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(pool.mutex);
+
+	// A worker that only woke up after the last call returned may still be
+	// looking at that call's job, let it find nothing left before replacing it.
+	pool.done.wait(lock, [&]() { return pool.active == 0; });
+
+	pool.job = job;
+	pool.jobCount = count;
+	pool.nextIndex = 0;
+	pool.generation++;
+
+	lock.unlock();
+
+	pool.wake.notify_all();
+
+	runJobs(pool, 0);
+
+	lock.lock();
+	pool.done.wait(lock, [&]() { return pool.active == 0; });
+
+	// Only now that no worker is still running the job, which may point
+	// at the caller's stack
+	if (pool.error) {
+		std::exception_ptr error = pool.error;
+		pool.error = nullptr;
+
+		lock.unlock();
+		std::rethrow_exception(error);
+	}
+}
\ No newline at end of file
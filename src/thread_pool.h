@@ -0,0 +1,39 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+namespace util {
+	// A fixed set of worker threads that parallelFor hands indices to. The
+	// calling thread works too and is thread 0, workers are 1..threads.size().
+	struct ThreadPool {
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+		std::function<void(uint32_t, uint32_t)> job;
+		uint32_t jobCount = 0;
+		std::atomic<uint32_t> nextIndex;
+		uint64_t generation = 0;
+		uint32_t active = 0;
+		bool quit = false;
+		// The first exception a job threw, guarded by mutex
+		std::exception_ptr error;
+	};
+
+	void initThreadPool(ThreadPool& pool, uint32_t threadCount);
+	void releaseThreadPool(ThreadPool& pool);
+	uint32_t getThreadCount(ThreadPool& pool);
+	// Calls job(index, thread) for every index in [0, count) and returns
+	// once all of them are done. If a job throws no further indices are
+	// started and the first exception is rethrown here once the others
+	// have finished.
+	void parallelFor(ThreadPool& pool, uint32_t count, std::function<void(uint32_t, uint32_t)> job);
+}
\ No newline at end of file
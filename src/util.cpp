@@ -25,6 +25,12 @@ void util::strSplit(std::string str, char delim, std::function<void(std::string)
 void util::loadBlob(std::string path, std::vector<char>& data) {
 	data.clear();
 	std::ifstream in(path, std::ios::binary);
+
+	// tellg would give -1 and resize would ask for everything
+	if (!in.is_open()) {
+		throw std::runtime_error("missing file " + path);
+	}
+
 	in.seekg(0, std::ios::end);
 	data.resize(in.tellg());
 	in.seekg(0, std::ios::beg);
@@ -57,34 +63,4 @@ glm::vec2 util::toVec2(std::string str) {
 		std::stof(temp[0]),
 		std::stof(temp[1])
 	);
-}
-
-// Rect
-void util::Rect::init(glm::vec2 p, glm::vec2 s) {
-	this->position = p;
-	this->size = s;
-}
-
-float util::Rect::left() {
-	return this->position.x;
-}
-
-float util::Rect::right() {
-	return this->position.x + this->size.x;
-}
-
-float util::Rect::top() {
-	return this->position.y;
-}
-
-float util::Rect::bottom() {
-	return this->position.y + this->size.y;
-}
-
-bool util::Rect::isCollide(Rect& r) {
-	return
-		this->left() < r.right() &&
-		this->right() > r.left() &&
-		this->top() < r.bottom() &&
-		this->bottom() > r.top();
 }
\ No newline at end of file
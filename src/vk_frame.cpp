@@ -0,0 +1,110 @@
+#include "sys.h"
+
+
+namespace vk {
+
+	bool beginFrame(Vulkan& v) {
+		// The frame slot's last submission has to finish before its fence
+		// and acquire semaphore can be used again. This is where the CPU
+		// is held framesInFlight frames behind the GPU.
+		vkWaitForFences(v.device, 1, &v.inFlight[v.currentFrame], VK_TRUE, UINT64_MAX);
+
+		if (v.headless) {
+			// The offscreen targets are used in turn
+			v.currentImage = (v.currentImage + 1) % v.swapchainImages.size();
+		}
+		else {
+			VkResult res = vkAcquireNextImageKHR(v.device, v.swapchain, UINT64_MAX, v.submitCB[v.currentFrame], VK_NULL_HANDLE, &v.currentImage);
+
+			// Nothing was acquired so the semaphore isn't signaled, skip the
+			// frame. A suboptimal image is still drawn and presented, the
+			// swapchain is replaced after that.
+			if (res == VK_ERROR_OUT_OF_DATE_KHR) {
+				v.swapchainOutOfDate = true;
+				return false;
+			}
+			else if (res == VK_SUBOPTIMAL_KHR) {
+				v.swapchainOutOfDate = true;
+			}
+			else if (res != VK_SUCCESS) {
+				throw std::runtime_error("failed to acquire swapchain image");
+			}
+		}
+
+		// Images can come back in any order, so the image may still be in
+		// use by a different frame slot than this one.
+		if (v.imageInFlight[v.currentImage] != VK_NULL_HANDLE) {
+			vkWaitForFences(v.device, 1, &v.imageInFlight[v.currentImage], VK_TRUE, UINT64_MAX);
+		}
+
+		v.imageInFlight[v.currentImage] = v.inFlight[v.currentFrame];
+
+		return true;
+	}
+
+	void waitFrame(Vulkan& v) {
+		vkWaitForFences(v.device, 1, &v.inFlight[v.currentFrame], VK_TRUE, UINT64_MAX);
+	}
+
+	void endFrame(Vulkan& v, VkCommandBuffer cb, std::vector<VkSemaphore>& waitSemaphores, std::vector<VkPipelineStageFlags>& waitStages) {
+		if (!v.headless) {
+			waitSemaphores.push_back(v.submitCB[v.currentFrame]);
+			waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		}
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.waitSemaphoreCount = waitSemaphores.size();
+		submitInfo.pWaitSemaphores = waitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
+
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &cb;
+
+		// Per image, as it is only free again once that image is presented
+		submitInfo.signalSemaphoreCount = v.headless ? 0 : 1;
+		submitInfo.pSignalSemaphores = &v.submitPresentQueue[v.currentImage];
+
+		vkResetFences(v.device, 1, &v.inFlight[v.currentFrame]);
+
+		if (vkQueueSubmit(v.graphicsQueue, 1, &submitInfo, v.inFlight[v.currentFrame]) != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit draw command buffer!");
+		}
+
+		if (v.timestamps.enabled) {
+			v.timestamps.submitted[v.currentImage] = true;
+		}
+
+		if (!v.headless) {
+			VkPresentInfoKHR presentInfo = {};
+			presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+
+			presentInfo.waitSemaphoreCount = 1;
+			presentInfo.pWaitSemaphores = &v.submitPresentQueue[v.currentImage];
+
+			presentInfo.swapchainCount = 1;
+			presentInfo.pSwapchains = &v.swapchain;
+
+			presentInfo.pImageIndices = &v.currentImage;
+
+			VkResult res = vkQueuePresentKHR(v.presentQueue, &presentInfo);
+
+			if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR) {
+				v.swapchainOutOfDate = true;
+			}
+			else if (res != VK_SUCCESS) {
+				throw std::runtime_error("failed to present swapchain image");
+			}
+		}
+
+		v.currentFrame = (v.currentFrame + 1) % v.framesInFlight;
+	}
+
+	void waitFrames(Vulkan& v) {
+		if (!v.inFlight.empty()) {
+			vkWaitForFences(v.device, v.inFlight.size(), v.inFlight.data(), VK_TRUE, UINT64_MAX);
+		}
+
+		std::fill(v.imageInFlight.begin(), v.imageInFlight.end(), VK_NULL_HANDLE);
+	}
+}
\ No newline at end of file
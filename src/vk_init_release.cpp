@@ -6,6 +6,9 @@ namespace vk {
 	struct QueueFamilyIndices {
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
+		// A family with transfer but no graphics or compute is a dedicated
+		// DMA engine; it falls back to the graphics family otherwise.
+		std::optional<uint32_t> transferFamily;
 
 		bool isComplete() {
 			return graphicsFamily.has_value() && presentFamily.has_value();
@@ -32,6 +35,9 @@ namespace vk {
 	void initDebugMessenger(Vulkan&);
 	// Surface
 	void initSurface(Vulkan&);
+	// Offscreen Targets
+	void initOffscreenTargets(Vulkan&);
+	void releaseOffscreenTargets(Vulkan&);
 	// Physical Device
 	void pickPhysicalDevice(Vulkan&);
 	bool isPhysicalDeviceSuitable(Vulkan& v, VkPhysicalDevice d);
@@ -50,6 +56,7 @@ namespace vk {
 	void initCommandPool(Vulkan&);
 	// Semaphore
 	void initSemaphore(Vulkan&);
+	void initPresentSemaphores(Vulkan&);
 	// Fence
 	void initFence(Vulkan&);
 
@@ -60,18 +67,87 @@ namespace vk {
 			vulkan.debug << "Opened debug.txt" << std::endl;
 			initDebugMessenger(vulkan);
 		}
-		initSurface(vulkan);
+		if (!vulkan.headless) {
+			initSurface(vulkan);
+		}
 		pickPhysicalDevice(vulkan);
 		initDevice(vulkan);
-		initSwapchain(vulkan);
+		initAllocator(vulkan);
+		initPipelineCache(vulkan);
+		if (vulkan.headless) {
+			initOffscreenTargets(vulkan);
+		}
+		else {
+			initSwapchain(vulkan);
+		}
 		initRenderPasses(vulkan);
 		initFramebuffer(vulkan);
 		initCommandPool(vulkan);
 		initSemaphore(vulkan);
 		initFence(vulkan);
+		initUploader(vulkan);
+	}
+
+	bool recreateSwapchain(Vulkan& vulkan) {
+		VkSurfaceCapabilitiesKHR caps;
+		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(vulkan.physicalDevice, vulkan.surface, &caps);
+
+		if (caps.currentExtent.width == 0 || caps.currentExtent.height == 0) {
+			return false;
+		}
+
+		// Waits for every frame in flight rather than only those using the
+		// old images, so nothing below is still in use on the GPU.
+		waitFrames(vulkan);
+
+		for (auto framebuffer : vulkan.framebuffer) {
+			vkDestroyFramebuffer(vulkan.device, framebuffer, nullptr);
+		}
+
+		for (auto imageView : vulkan.swapchainImageViews) {
+			vkDestroyImageView(vulkan.device, imageView, nullptr);
+		}
+
+		size_t imageCount = vulkan.swapchainImages.size();
+		VkFormat format = vulkan.swapchainImageFormat;
+
+		initSwapchain(vulkan);
+
+		// The caller rebuilds its pipelines, they were made for the old pass
+		if (vulkan.swapchainImageFormat != format) {
+			vkDestroyRenderPass(vulkan.device, vulkan.renderPass, nullptr);
+			initRenderPasses(vulkan);
+		}
+
+		if (vulkan.swapchainImages.size() != imageCount) {
+			// A present can still be waiting on these, no fence covers that
+			vkQueueWaitIdle(vulkan.presentQueue);
+
+			for (auto s : vulkan.submitPresentQueue) {
+				vkDestroySemaphore(vulkan.device, s, nullptr);
+			}
+
+			initPresentSemaphores(vulkan);
+
+			vulkan.imageInFlight.assign(vulkan.swapchainImages.size(), VK_NULL_HANDLE);
+
+			if (vulkan.timestamps.pool) {
+				uint32_t queriesPerImage = vulkan.timestamps.queriesPerImage;
+				releaseTimestamps(vulkan);
+				initTimestamps(vulkan, queriesPerImage);
+			}
+		}
+
+		initFramebuffer(vulkan);
+
+		std::cout << "Success: Recreate Swapchain (" << vulkan.swapchainExtent.width << "x" << vulkan.swapchainExtent.height << ")" << std::endl;
+
+		return true;
 	}
 
 	void releaseVulkan(Vulkan& vulkan) {
+		releaseUploader(vulkan);
+
 		for (auto fence : vulkan.inFlight) {
 			vkDestroyFence(vulkan.device, fence, nullptr);
 		}
@@ -104,6 +180,13 @@ namespace vk {
 			vkDestroySwapchainKHR(vulkan.device, vulkan.swapchain, nullptr);
 		}
 
+		if (vulkan.headless) {
+			releaseOffscreenTargets(vulkan);
+		}
+
+		releasePipelineCache(vulkan);
+		releaseAllocator(vulkan);
+
 		if (vulkan.device) {
 			vkDestroyDevice(vulkan.device, nullptr);
 		}
@@ -133,6 +216,25 @@ namespace vk {
 
 	// Instance
 	void initInstance(Vulkan& v) {
+		// CI machines usually don't have the SDK's layers installed
+		if (v.enableValidationLayers) {
+			uint32_t count = 0;
+			vkEnumerateInstanceLayerProperties(&count, nullptr);
+			std::vector<VkLayerProperties> layers(count);
+			vkEnumerateInstanceLayerProperties(&count, layers.data());
+
+			for (const char* name : v.validationLayers) {
+				bool found = std::any_of(layers.begin(), layers.end(), [&](const VkLayerProperties& l) {
+					return strcmp(l.layerName, name) == 0;
+				});
+
+				if (!found) {
+					std::cout << "Instance: " << name << " not available, validation disabled" << std::endl;
+					v.enableValidationLayers = false;
+				}
+			}
+		}
+
 		// Application Info
 		VkApplicationInfo appInfo = {};
 		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -169,8 +271,10 @@ namespace vk {
 
 	// Debug Section
 	void getInstanceExtensions(Vulkan& v, std::vector<const char*>& ext) {
-		ext.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
-		ext.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+		if (!v.headless) {
+			ext.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+			ext.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+		}
 
 		if (v.enableValidationLayers) {
 			ext.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -263,6 +367,12 @@ namespace vk {
 	bool isPhysicalDeviceSuitable(Vulkan& v, VkPhysicalDevice d) {
 		QueueFamilyIndices indices;
 		indices = findQueueFamilies(v, d);
+
+		// Only a graphics queue is needed to render offscreen
+		if (v.headless) {
+			return indices.isComplete();
+		}
+
 		bool extensionSupport = checkDeviceExtensionSupport(v, d);
 
 		bool swapChainAdequate = false;
@@ -289,7 +399,14 @@ namespace vk {
 			}
 
 			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(d, i, v.surface, &presentSupport);
+
+			if (v.headless) {
+				// Nothing is presented, graphics stands in for present
+				presentSupport = indices.graphicsFamily.has_value() && indices.graphicsFamily.value() == i;
+			}
+			else {
+				vkGetPhysicalDeviceSurfaceSupportKHR(d, i, v.surface, &presentSupport);
+			}
 
 			if (presentSupport) {
 				indices.presentFamily = i;
@@ -301,6 +418,19 @@ namespace vk {
 			i++;
 		}
 
+		for (uint32_t j = 0; j < props.size(); j++) {
+			VkQueueFlags f = props[j].queueFlags;
+
+			if ((f & VK_QUEUE_TRANSFER_BIT) && !(f & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+				indices.transferFamily = j;
+				break;
+			}
+		}
+
+		if (!indices.transferFamily.has_value()) {
+			indices.transferFamily = indices.graphicsFamily;
+		}
+
 		return indices;
 	}
 
@@ -371,7 +501,8 @@ namespace vk {
 
 		std::set<uint32_t> uniqueQueueFamily = {
 			indices.graphicsFamily.value(),
-			indices.presentFamily.value()
+			indices.presentFamily.value(),
+			indices.transferFamily.value()
 		};
 
 		for (uint32_t q : uniqueQueueFamily) {
@@ -395,8 +526,10 @@ namespace vk {
 			CI.ppEnabledLayerNames = v.validationLayers.data();
 		}
 
-		CI.enabledExtensionCount = v.deviceExtensions.size();
-		CI.ppEnabledExtensionNames = v.deviceExtensions.data();
+		if (!v.headless) {
+			CI.enabledExtensionCount = v.deviceExtensions.size();
+			CI.ppEnabledExtensionNames = v.deviceExtensions.data();
+		}
 
 		VkResult res = vkCreateDevice(v.physicalDevice, &CI, nullptr, &v.device);
 
@@ -409,6 +542,14 @@ namespace vk {
 
 		vkGetDeviceQueue(v.device, indices.graphicsFamily.value(), 0, &v.graphicsQueue);
 		vkGetDeviceQueue(v.device, indices.presentFamily.value(), 0, &v.presentQueue);
+		vkGetDeviceQueue(v.device, indices.transferFamily.value(), 0, &v.transferQueue);
+
+		v.graphicsFamily = indices.graphicsFamily.value();
+		v.transferFamily = indices.transferFamily.value();
+
+		if (v.transferFamily != v.graphicsFamily) {
+			std::cout << "Device: using dedicated transfer queue family " << v.transferFamily << std::endl;
+		}
 	}
 
 	// Swapchain
@@ -426,15 +567,20 @@ namespace vk {
 		}
 
 		// Present Mode
+		// FIFO is the only mode every surface has to support
 		VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
 
 		for (const auto& p : details.presentModes) {
-			if (p == VK_PRESENT_MODE_MAILBOX_KHR) {
+			if (p == v.presentMode) {
 				presentMode = p;
 				break;
 			}
 		}
 
+		if (presentMode != v.presentMode) {
+			std::cout << "SwapChain: requested present mode not supported, using FIFO" << std::endl;
+		}
+
 		// Extern 2D
 		VkExtent2D extent;
 		if (details.caps.currentExtent.width != UINT32_MAX) {
@@ -511,7 +657,9 @@ namespace vk {
 		CI.presentMode = presentMode;
 		CI.clipped = VK_TRUE;
 
-		CI.oldSwapchain = VK_NULL_HANDLE;
+		// Lets the driver hand resources over from the swapchain being replaced
+		VkSwapchainKHR oldSwapchain = v.swapchain;
+		CI.oldSwapchain = oldSwapchain;
 
 		VkResult res = vkCreateSwapchainKHR(v.device, &CI, nullptr, &v.swapchain);
 
@@ -522,6 +670,10 @@ namespace vk {
 			std::cout << "Success: Create Swapchain" << std::endl;
 		}
 
+		if (oldSwapchain) {
+			vkDestroySwapchainKHR(v.device, oldSwapchain, nullptr);
+		}
+
 
 
 		// ---- Image ---- //
@@ -564,6 +716,80 @@ namespace vk {
 		}
 	}
 
+	// Offscreen Targets
+	void initOffscreenTargets(Vulkan& v) {
+		// As many as a swapchain would usually hand out
+		const uint32_t imageCount = 3;
+
+		v.swapchainImageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+		v.swapchainExtent = { app::getWidth(), app::getHeight() };
+
+		v.swapchainImages.resize(imageCount);
+		v.swapchainImageViews.resize(imageCount);
+		v.offscreenMemory.resize(imageCount);
+
+		for (uint32_t i = 0; i < imageCount; i++) {
+			VkImageCreateInfo CI = {};
+			CI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			CI.imageType = VK_IMAGE_TYPE_2D;
+			CI.format = v.swapchainImageFormat;
+			CI.extent = { v.swapchainExtent.width, v.swapchainExtent.height, 1 };
+			CI.mipLevels = 1;
+			CI.arrayLayers = 1;
+			CI.samples = VK_SAMPLE_COUNT_1_BIT;
+			CI.tiling = VK_IMAGE_TILING_OPTIMAL;
+			CI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			CI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			CI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			VkResult res = vkCreateImage(v.device, &CI, nullptr, &v.swapchainImages[i]);
+
+			if (res != VK_SUCCESS) {
+				throw std::runtime_error("failed to create offscreen image");
+			}
+
+			v.offscreenMemory[i] = allocateImage(v, v.swapchainImages[i], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			VkImageViewCreateInfo temp = {};
+			temp.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			temp.image = v.swapchainImages[i];
+			temp.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			temp.format = v.swapchainImageFormat;
+			temp.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+			temp.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+			temp.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+			temp.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+			temp.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			temp.subresourceRange.baseMipLevel = 0;
+			temp.subresourceRange.levelCount = 1;
+			temp.subresourceRange.baseArrayLayer = 0;
+			temp.subresourceRange.layerCount = 1;
+
+			res = vkCreateImageView(v.device, &temp, nullptr, &v.swapchainImageViews[i]);
+
+			if (res != VK_SUCCESS) {
+				throw std::runtime_error("failed to create offscreen image view");
+			}
+			else {
+				std::cout << "Success: Create Offscreen Image [" << i << "]" << std::endl;
+			}
+		}
+	}
+
+	// The views are destroyed with the swapchain's
+	void releaseOffscreenTargets(Vulkan& v) {
+		for (auto image : v.swapchainImages) {
+			vkDestroyImage(v.device, image, nullptr);
+		}
+
+		for (auto& memory : v.offscreenMemory) {
+			freeMemory(v, memory);
+		}
+
+		v.swapchainImages.clear();
+		v.offscreenMemory.clear();
+	}
+
 	// Render Passes
 	void initRenderPasses(Vulkan& v) {
 		// Color Attachments
@@ -575,7 +801,8 @@ namespace vk {
 		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		// Offscreen targets are left ready to be copied out instead of presented
+		colorAttachment.finalLayout = v.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 		// Subpass Reference
 		VkAttachmentReference colorAttachmentRef = {};
@@ -651,7 +878,8 @@ namespace vk {
 		VkCommandPoolCreateInfo poolInfo = {};
 		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 		poolInfo.queueFamilyIndex = family.graphicsFamily.value();
-		poolInfo.flags = 0;
+		// Command buffers are re-recorded one at a time when the render path changes
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
 		VkResult res = vkCreateCommandPool(v.device, &poolInfo, nullptr, &v.commandPool);
 
@@ -669,9 +897,9 @@ namespace vk {
 		CI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
 		// SubmitCB
-		v.submitCB.resize(v.swapchainImages.size());
+		v.submitCB.resize(v.framesInFlight);
 
-		for (size_t i = 0; i < v.swapchainImages.size(); i++) {
+		for (size_t i = 0; i < v.submitCB.size(); i++) {
 			VkResult res = vkCreateSemaphore(v.device, &CI, nullptr, &v.submitCB[i]);
 			if (res != VK_SUCCESS) {
 				throw std::runtime_error("failed to create submitCB");
@@ -681,7 +909,14 @@ namespace vk {
 			}
 		}
 
-		// Submit Present Queue
+		initPresentSemaphores(v);
+	}
+
+	// Per image, so created again when the swapchain's image count changes
+	void initPresentSemaphores(Vulkan& v) {
+		VkSemaphoreCreateInfo CI = {};
+		CI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
 		v.submitPresentQueue.resize(v.swapchainImages.size());
 
 		for (size_t i = 0; i < v.swapchainImages.size(); i++) {
@@ -699,9 +934,11 @@ namespace vk {
 	void initFence(Vulkan& v) {
 		VkFenceCreateInfo CI = {};
 		CI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		
-		v.inFlight.resize(v.swapchainImages.size());
-		v.imageInFlight.resize(v.swapchainImages.size());
+		// Signaled so the first wait on each frame's fence returns
+		CI.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		v.inFlight.resize(v.framesInFlight);
+		v.imageInFlight.resize(v.swapchainImages.size(), VK_NULL_HANDLE);
 
 		for (size_t i = 0; i < v.inFlight.size(); i++) {
 			VkResult res = vkCreateFence(v.device, &CI, nullptr, &v.inFlight[i]);
@@ -0,0 +1,331 @@
+#include "sys.h"
+
+
+namespace vk {
+
+	VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment);
+	void initMemoryBlock(Vulkan& v, MemoryBlock& block, uint32_t memoryType, VkDeviceSize size);
+	void releaseMemoryBlock(Vulkan& v, MemoryBlock& block);
+	bool allocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+
+	void initAllocator(Vulkan& v) {
+		MemoryAllocator& a = v.allocator;
+
+		vkGetPhysicalDeviceMemoryProperties(v.physicalDevice, &a.memProps);
+
+		VkPhysicalDeviceProperties props;
+		vkGetPhysicalDeviceProperties(v.physicalDevice, &props);
+
+		a.maxAllocationCount = props.limits.maxMemoryAllocationCount;
+		a.allocationCount = 0;
+		a.pools.clear();
+		a.pools.resize(a.memProps.memoryTypeCount * 2);
+
+		std::cout << "Success: Init Memory Allocator (" << a.memProps.memoryTypeCount << " memory types)" << std::endl;
+	}
+
+	void releaseAllocator(Vulkan& v) {
+		reportMemory(v);
+
+		for (auto& pool : v.allocator.pools) {
+			for (auto& block : pool) {
+				if (block.allocationCount > 0) {
+					std::cout << "Memory: " << block.allocationCount << " allocations still live at release" << std::endl;
+				}
+				releaseMemoryBlock(v, block);
+			}
+		}
+
+		v.allocator.pools.clear();
+		v.allocator.allocationCount = 0;
+	}
+
+	uint32_t findMemoryType(Vulkan& v, uint32_t typeBits, VkMemoryPropertyFlags props) {
+		const VkPhysicalDeviceMemoryProperties& memProps = v.allocator.memProps;
+
+		for (uint32_t i = 0; i < memProps.memoryTypeCount; i++) {
+			if ((typeBits & (1 << i)) && (memProps.memoryTypes[i].propertyFlags & props) == props) {
+				return i;
+			}
+		}
+
+		throw std::runtime_error("failed to find memory type");
+	}
+
+	MemoryAllocation allocateMemory(Vulkan& v, const VkMemoryRequirements& req, VkMemoryPropertyFlags props, bool linear) {
+		MemoryAllocator& a = v.allocator;
+
+		MemoryAllocation allocation;
+		allocation.memoryType = findMemoryType(v, req.memoryTypeBits, props);
+		allocation.pool = allocation.memoryType * 2 + (linear ? 0 : 1);
+		allocation.size = req.size;
+
+		std::vector<MemoryBlock>& pool = a.pools[allocation.pool];
+
+		bool found = false;
+
+		for (uint32_t i = 0; i < pool.size() && !found; i++) {
+			if (allocateFromBlock(pool[i], req.size, req.alignment, allocation.offset)) {
+				allocation.block = i;
+				found = true;
+			}
+		}
+
+		if (!found) {
+			// Anything bigger than half a block gets a block of its own so a
+			// single large resource can't strand the rest of a shared one.
+			VkDeviceSize size = a.blockSize;
+
+			if (req.size > a.blockSize / 2) {
+				size = alignUp(req.size, req.alignment);
+			}
+
+			// Reuse a slot left by a released block before growing the pool
+			allocation.block = pool.size();
+			for (uint32_t i = 0; i < pool.size(); i++) {
+				if (pool[i].memory == VK_NULL_HANDLE) {
+					allocation.block = i;
+					break;
+				}
+			}
+
+			if (allocation.block == pool.size()) {
+				pool.push_back(MemoryBlock());
+			}
+
+			initMemoryBlock(v, pool[allocation.block], allocation.memoryType, size);
+
+			if (!allocateFromBlock(pool[allocation.block], req.size, req.alignment, allocation.offset)) {
+				throw std::runtime_error("failed to sub allocate memory");
+			}
+		}
+
+		MemoryBlock& block = pool[allocation.block];
+
+		allocation.memory = block.memory;
+
+		if (block.mapped) {
+			allocation.mapped = block.mapped + allocation.offset;
+		}
+
+		return allocation;
+	}
+
+	void freeMemory(Vulkan& v, MemoryAllocation& allocation) {
+		if (allocation.memory == VK_NULL_HANDLE) {
+			return;
+		}
+
+		std::vector<MemoryBlock>& pool = v.allocator.pools[allocation.pool];
+		MemoryBlock& block = pool[allocation.block];
+
+		auto it = block.freeList.emplace(allocation.offset, allocation.size).first;
+
+		// Coalesce with the following range
+		auto next = std::next(it);
+		if (next != block.freeList.end() && it->first + it->second == next->first) {
+			it->second += next->second;
+			block.freeList.erase(next);
+		}
+
+		// Coalesce with the preceding range
+		if (it != block.freeList.begin()) {
+			auto prev = std::prev(it);
+			if (prev->first + prev->second == it->first) {
+				prev->second += it->second;
+				block.freeList.erase(it);
+			}
+		}
+
+		block.used -= allocation.size;
+		block.allocationCount--;
+
+		// Keep the first block of every pool around, any other block goes
+		// back to the driver once it is empty.
+		if (block.allocationCount == 0 && allocation.block > 0) {
+			releaseMemoryBlock(v, block);
+		}
+
+		allocation = MemoryAllocation();
+	}
+
+	MemoryAllocation allocateBuffer(Vulkan& v, VkBuffer buffer, VkMemoryPropertyFlags props) {
+		VkMemoryRequirements req;
+		vkGetBufferMemoryRequirements(v.device, buffer, &req);
+
+		MemoryAllocation allocation = allocateMemory(v, req, props, true);
+
+		VkResult res = vkBindBufferMemory(v.device, buffer, allocation.memory, allocation.offset);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to bind buffer memory");
+		}
+
+		return allocation;
+	}
+
+	MemoryAllocation allocateImage(Vulkan& v, VkImage image, VkMemoryPropertyFlags props) {
+		VkMemoryRequirements req;
+		vkGetImageMemoryRequirements(v.device, image, &req);
+
+		MemoryAllocation allocation = allocateMemory(v, req, props, false);
+
+		VkResult res = vkBindImageMemory(v.device, image, allocation.memory, allocation.offset);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to bind image memory");
+		}
+
+		return allocation;
+	}
+
+	void reportMemory(Vulkan& v) {
+		MemoryAllocator& a = v.allocator;
+
+		std::cout << "Memory: " << a.allocationCount << " / " << a.maxAllocationCount << " device allocations" << std::endl;
+
+		for (size_t p = 0; p < a.pools.size(); p++) {
+			VkDeviceSize total = 0;
+			VkDeviceSize used = 0;
+			VkDeviceSize largestFree = 0;
+			uint32_t blocks = 0;
+			uint32_t allocations = 0;
+
+			for (auto& block : a.pools[p]) {
+				if (block.memory == VK_NULL_HANDLE) {
+					continue;
+				}
+
+				blocks++;
+				total += block.size;
+				used += block.used;
+				allocations += block.allocationCount;
+
+				for (auto& range : block.freeList) {
+					largestFree = std::max(largestFree, range.second);
+				}
+			}
+
+			if (blocks == 0) {
+				continue;
+			}
+
+			// 0% when all free space is one range, towards 100% as it gets
+			// split into pieces too small to serve a large request.
+			VkDeviceSize free = total - used;
+			float fragmentation = (free > 0) ? 1.0f - (float)largestFree / (float)free : 0.0f;
+
+			std::cout << "Memory: type " << p / 2 << ((p % 2 == 0) ? " (linear)" : " (optimal)")
+				<< " blocks " << blocks
+				<< " allocations " << allocations
+				<< " used " << used / 1024 << "KB / " << total / 1024 << "KB"
+				<< " fragmentation " << (int)(fragmentation * 100.0f) << "%" << std::endl;
+		}
+	}
+
+	VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	void initMemoryBlock(Vulkan& v, MemoryBlock& block, uint32_t memoryType, VkDeviceSize size) {
+		MemoryAllocator& a = v.allocator;
+
+		if (a.allocationCount >= a.maxAllocationCount) {
+			throw std::runtime_error("reached maxMemoryAllocationCount");
+		}
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		VkResult res = vkAllocateMemory(v.device, &allocInfo, nullptr, &block.memory);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate memory block");
+		}
+		else {
+			std::cout << "Success: Allocate Memory Block (type " << memoryType << ", " << size / 1024 << "KB)" << std::endl;
+		}
+
+		a.allocationCount++;
+
+		block.size = size;
+		block.used = 0;
+		block.allocationCount = 0;
+		block.freeList.clear();
+		block.freeList[0] = size;
+		block.mapped = nullptr;
+
+		if (a.memProps.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+			void* data = nullptr;
+			vkMapMemory(v.device, block.memory, 0, VK_WHOLE_SIZE, 0, &data);
+			block.mapped = (uint8_t*)data;
+		}
+	}
+
+	void releaseMemoryBlock(Vulkan& v, MemoryBlock& block) {
+		if (block.memory == VK_NULL_HANDLE) {
+			return;
+		}
+
+		if (block.mapped) {
+			vkUnmapMemory(v.device, block.memory);
+		}
+
+		vkFreeMemory(v.device, block.memory, nullptr);
+
+		v.allocator.allocationCount--;
+
+		block = MemoryBlock();
+	}
+
+	// Best fit: the smallest free range that still holds the aligned size,
+	// which keeps large ranges intact for large requests.
+	bool allocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+		if (block.memory == VK_NULL_HANDLE) {
+			return false;
+		}
+
+		auto best = block.freeList.end();
+		VkDeviceSize bestOffset = 0;
+
+		for (auto it = block.freeList.begin(); it != block.freeList.end(); it++) {
+			VkDeviceSize aligned = alignUp(it->first, alignment);
+
+			if (aligned + size > it->first + it->second) {
+				continue;
+			}
+
+			if (best == block.freeList.end() || it->second < best->second) {
+				best = it;
+				bestOffset = aligned;
+			}
+		}
+
+		if (best == block.freeList.end()) {
+			return false;
+		}
+
+		VkDeviceSize rangeOffset = best->first;
+		VkDeviceSize rangeEnd = best->first + best->second;
+
+		block.freeList.erase(best);
+
+		// Padding in front of the aligned offset stays free
+		if (bestOffset > rangeOffset) {
+			block.freeList[rangeOffset] = bestOffset - rangeOffset;
+		}
+
+		if (bestOffset + size < rangeEnd) {
+			block.freeList[bestOffset + size] = rangeEnd - (bestOffset + size);
+		}
+
+		block.used += size;
+		block.allocationCount++;
+
+		offset = bestOffset;
+
+		return true;
+	}
+}
\ No newline at end of file
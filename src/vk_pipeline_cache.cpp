@@ -0,0 +1,129 @@
+#include "sys.h"
+
+
+namespace vk {
+
+	// Where the cache is kept between runs, next to debug.txt
+	const std::string pipelineCachePath = "pipeline_cache.bin";
+
+	// The data only helps the exact driver and device that wrote it, anything
+	// else is dropped and the cache starts empty.
+	bool isPipelineCacheValid(Vulkan& v, const std::vector<char>& data) {
+		const uint32_t headerSize = 16 + VK_UUID_SIZE;
+
+		if (data.size() < headerSize) {
+			return false;
+		}
+
+		uint32_t header[4];
+		memcpy(header, data.data(), sizeof(header));
+
+		VkPhysicalDeviceProperties props;
+		vkGetPhysicalDeviceProperties(v.physicalDevice, &props);
+
+		if (header[0] < headerSize || header[0] > data.size()) {
+			std::cout << "Pipeline Cache: bad header length" << std::endl;
+			return false;
+		}
+
+		if (header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+			std::cout << "Pipeline Cache: unknown header version" << std::endl;
+			return false;
+		}
+
+		if (header[2] != props.vendorID || header[3] != props.deviceID) {
+			std::cout << "Pipeline Cache: written by another device" << std::endl;
+			return false;
+		}
+
+		if (memcmp(data.data() + 16, props.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+			std::cout << "Pipeline Cache: written by another driver" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	void initPipelineCache(Vulkan& v) {
+		std::vector<char> data;
+
+		std::ifstream in(pipelineCachePath, std::ios::binary | std::ios::ate);
+
+		if (in.is_open()) {
+			data.resize(in.tellg());
+			in.seekg(0, std::ios::beg);
+			in.read(data.data(), data.size());
+			in.close();
+		}
+
+		v.pipelineCacheLoaded = !data.empty() && isPipelineCacheValid(v, data);
+
+		VkPipelineCacheCreateInfo CI = {};
+		CI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		if (v.pipelineCacheLoaded) {
+			CI.initialDataSize = data.size();
+			CI.pInitialData = data.data();
+		}
+
+		VkResult res = vkCreatePipelineCache(v.device, &CI, nullptr, &v.pipelineCache);
+
+		// A driver may still refuse data that passed the header checks
+		if (res != VK_SUCCESS && v.pipelineCacheLoaded) {
+			v.pipelineCacheLoaded = false;
+			CI.initialDataSize = 0;
+			CI.pInitialData = nullptr;
+			res = vkCreatePipelineCache(v.device, &CI, nullptr, &v.pipelineCache);
+		}
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to create pipeline cache");
+		}
+		else {
+			std::cout << "Success: Create Pipeline Cache ("
+				<< (v.pipelineCacheLoaded ? "loaded " + std::to_string(data.size()) + " bytes" : "empty")
+				<< ")" << std::endl;
+		}
+	}
+
+	void releasePipelineCache(Vulkan& v) {
+		if (!v.pipelineCache) {
+			return;
+		}
+
+		size_t size = 0;
+		vkGetPipelineCacheData(v.device, v.pipelineCache, &size, nullptr);
+
+		std::vector<char> data(size);
+
+		if (size > 0 && vkGetPipelineCacheData(v.device, v.pipelineCache, &size, data.data()) == VK_SUCCESS) {
+			// Written next to the real file and renamed over it, so a crash
+			// half way through can't leave a truncated cache behind.
+			std::string temp = pipelineCachePath + ".tmp";
+
+			std::ofstream out(temp, std::ios::binary);
+			out.write(data.data(), size);
+			out.close();
+
+			// The old cache is only removed, as Windows won't rename over it,
+			// once the new one is known to be complete.
+			if (!out.good()) {
+				std::remove(temp.c_str());
+				std::cout << "Pipeline Cache: couldn't write " << temp << ", kept the old cache" << std::endl;
+			}
+			else {
+				std::remove(pipelineCachePath.c_str());
+
+				if (std::rename(temp.c_str(), pipelineCachePath.c_str()) == 0) {
+					std::cout << "Pipeline Cache: saved " << size << " bytes" << std::endl;
+				}
+				else {
+					std::cout << "Pipeline Cache: couldn't rename " << temp << " to " << pipelineCachePath << std::endl;
+				}
+			}
+		}
+
+		vkDestroyPipelineCache(v.device, v.pipelineCache, nullptr);
+		v.pipelineCache = VK_NULL_HANDLE;
+	}
+}
\ No newline at end of file
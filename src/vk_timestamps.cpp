@@ -0,0 +1,110 @@
+#include "sys.h"
+
+
+namespace vk {
+
+	void initTimestamps(Vulkan& v, uint32_t queriesPerImage) {
+		Timestamps& t = v.timestamps;
+
+		uint32_t count = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(v.physicalDevice, &count, nullptr);
+		std::vector<VkQueueFamilyProperties> props(count);
+		vkGetPhysicalDeviceQueueFamilyProperties(v.physicalDevice, &count, props.data());
+
+		uint32_t validBits = props[v.graphicsFamily].timestampValidBits;
+
+		VkPhysicalDeviceProperties deviceProps;
+		vkGetPhysicalDeviceProperties(v.physicalDevice, &deviceProps);
+
+		// A queue that can't write timestamps reports 0 valid bits, every
+		// timestamp call is then a no-op and no GPU times are reported.
+		if (validBits == 0) {
+			t.enabled = false;
+			std::cout << "Timestamps: not supported on the graphics queue" << std::endl;
+			return;
+		}
+
+		t.queriesPerImage = queriesPerImage;
+		t.period = deviceProps.limits.timestampPeriod;
+		t.mask = (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1);
+		t.submitted.assign(v.swapchainImages.size(), false);
+		t.results.resize(queriesPerImage);
+
+		VkQueryPoolCreateInfo CI = {};
+		CI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		CI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		CI.queryCount = queriesPerImage * v.swapchainImages.size();
+
+		VkResult res = vkCreateQueryPool(v.device, &CI, nullptr, &t.pool);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to create timestamp query pool");
+		}
+		else {
+			std::cout << "Success: Create Timestamp Query Pool (" << validBits << " valid bits)" << std::endl;
+		}
+
+		t.enabled = true;
+	}
+
+	void releaseTimestamps(Vulkan& v) {
+		if (v.timestamps.pool) {
+			vkDestroyQueryPool(v.device, v.timestamps.pool, nullptr);
+		}
+
+		v.timestamps = Timestamps();
+	}
+
+	void resetTimestamps(Vulkan& v, VkCommandBuffer cb, uint32_t image) {
+		Timestamps& t = v.timestamps;
+
+		if (!t.enabled) {
+			return;
+		}
+
+		vkCmdResetQueryPool(cb, t.pool, image * t.queriesPerImage, t.queriesPerImage);
+	}
+
+	void writeTimestamp(Vulkan& v, VkCommandBuffer cb, uint32_t image, uint32_t query, VkPipelineStageFlagBits stage) {
+		Timestamps& t = v.timestamps;
+
+		if (!t.enabled) {
+			return;
+		}
+
+		vkCmdWriteTimestamp(cb, stage, t.pool, image * t.queriesPerImage + query);
+	}
+
+	bool readTimestamps(Vulkan& v, uint32_t image, std::vector<double>& ms) {
+		Timestamps& t = v.timestamps;
+
+		if (!t.enabled || !t.submitted[image]) {
+			return false;
+		}
+
+		// No WAIT bit, by the time an image comes around again its last
+		// frame has normally finished, if it hasn't it is simply skipped.
+		VkResult res = vkGetQueryPoolResults(
+			v.device,
+			t.pool,
+			image * t.queriesPerImage,
+			t.queriesPerImage,
+			t.results.size() * sizeof(uint64_t),
+			t.results.data(),
+			sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT);
+
+		if (res != VK_SUCCESS) {
+			return false;
+		}
+
+		ms.resize(t.queriesPerImage);
+
+		for (uint32_t i = 0; i < t.queriesPerImage; i++) {
+			uint64_t ticks = (t.results[i] - t.results[0]) & t.mask;
+			ms[i] = ticks * t.period / 1000000.0;
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
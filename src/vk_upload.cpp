@@ -0,0 +1,254 @@
+#include "sys.h"
+
+
+namespace vk {
+
+	// Staging space each batch starts with, a single larger copy gets a
+	// batch of its own sized to fit.
+	const VkDeviceSize uploadStageSize = 4 * 1024 * 1024;
+
+	void initUploadBatch(Vulkan& v, UploadBatch& batch, VkDeviceSize stageSize);
+	void releaseUploadBatch(Vulkan& v, UploadBatch& batch);
+	UploadBatch& beginUploadBatch(Vulkan& v, VkDeviceSize size);
+
+	void initUploader(Vulkan& v) {
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = v.transferFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		VkResult res = vkCreateCommandPool(v.device, &poolInfo, nullptr, &v.uploader.commandPool);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to create upload command pool");
+		}
+		else {
+			std::cout << "Success: Create Upload Command Pool" << std::endl;
+		}
+
+		v.uploader.familyIndices.clear();
+		v.uploader.familyIndices.push_back(v.graphicsFamily);
+
+		if (v.transferFamily != v.graphicsFamily) {
+			v.uploader.familyIndices.push_back(v.transferFamily);
+		}
+	}
+
+	void releaseUploader(Vulkan& v) {
+		waitUploads(v);
+
+		for (auto& batch : v.uploader.batches) {
+			releaseUploadBatch(v, batch);
+		}
+
+		v.uploader.batches.clear();
+		v.uploader.current.reset();
+
+		if (v.uploader.commandPool) {
+			vkDestroyCommandPool(v.device, v.uploader.commandPool, nullptr);
+		}
+	}
+
+	void shareWithTransfer(Vulkan& v, VkBufferCreateInfo& CI) {
+		if (v.uploader.familyIndices.size() > 1) {
+			CI.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			CI.queueFamilyIndexCount = v.uploader.familyIndices.size();
+			CI.pQueueFamilyIndices = v.uploader.familyIndices.data();
+		}
+		else {
+			CI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			CI.queueFamilyIndexCount = 0;
+			CI.pQueueFamilyIndices = nullptr;
+		}
+	}
+
+	void uploadBuffer(Vulkan& v, VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size) {
+		UploadBatch& batch = beginUploadBatch(v, size);
+
+		memcpy(batch.stageData + batch.stageUsed, data, size);
+
+		VkBufferCopy cr = {};
+		cr.srcOffset = batch.stageUsed;
+		cr.dstOffset = dstOffset;
+		cr.size = size;
+		vkCmdCopyBuffer(batch.commandBuffer, batch.stageBuffer, dst, 1, &cr);
+
+		// Keep every copy's source 16 byte aligned
+		batch.stageUsed = (batch.stageUsed + size + 15) & ~VkDeviceSize(15);
+	}
+
+	void submitUploads(Vulkan& v) {
+		if (!v.uploader.current.has_value()) {
+			return;
+		}
+
+		UploadBatch& batch = v.uploader.batches[v.uploader.current.value()];
+		v.uploader.current.reset();
+
+		vkEndCommandBuffer(batch.commandBuffer);
+
+		VkSubmitInfo sub = {};
+		sub.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		sub.commandBufferCount = 1;
+		sub.pCommandBuffers = &batch.commandBuffer;
+		sub.signalSemaphoreCount = 1;
+		sub.pSignalSemaphores = &batch.semaphore;
+
+		VkResult res = vkQueueSubmit(v.transferQueue, 1, &sub, batch.fence);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to submit upload batch");
+		}
+
+		batch.recording = false;
+		batch.submitted = true;
+		batch.semaphoreTaken = false;
+	}
+
+	void takeUploadSemaphores(Vulkan& v, std::vector<VkSemaphore>& semaphores) {
+		for (auto& batch : v.uploader.batches) {
+			if (batch.submitted && !batch.semaphoreTaken) {
+				semaphores.push_back(batch.semaphore);
+				batch.semaphoreTaken = true;
+			}
+		}
+	}
+
+	void waitUploads(Vulkan& v) {
+		submitUploads(v);
+
+		for (auto& batch : v.uploader.batches) {
+			if (batch.submitted) {
+				vkWaitForFences(v.device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+			}
+		}
+	}
+
+	void initUploadBatch(Vulkan& v, UploadBatch& batch, VkDeviceSize stageSize) {
+		VkCommandBufferAllocateInfo ai = {};
+		ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		ai.commandPool = v.uploader.commandPool;
+		ai.commandBufferCount = 1;
+
+		VkResult res = vkAllocateCommandBuffers(v.device, &ai, &batch.commandBuffer);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate upload commandBuffer");
+		}
+
+		VkFenceCreateInfo fCI = {};
+		fCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		res = vkCreateFence(v.device, &fCI, nullptr, &batch.fence);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to create upload fence");
+		}
+
+		VkSemaphoreCreateInfo sCI = {};
+		sCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		res = vkCreateSemaphore(v.device, &sCI, nullptr, &batch.semaphore);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to create upload semaphore");
+		}
+
+		VkBufferCreateInfo CI = {};
+		CI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		CI.size = stageSize;
+		CI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		CI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		res = vkCreateBuffer(v.device, &CI, nullptr, &batch.stageBuffer);
+
+		if (res != VK_SUCCESS) {
+			throw std::runtime_error("failed to create upload stageBuffer");
+		}
+
+		batch.stageMemory = allocateBuffer(v, batch.stageBuffer,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+			VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		batch.stageData = batch.stageMemory.mapped;
+		batch.stageSize = stageSize;
+
+		std::cout << "Success: Create Upload Batch [" << v.uploader.batches.size() - 1 << "]" << std::endl;
+	}
+
+	void releaseUploadBatch(Vulkan& v, UploadBatch& batch) {
+		freeMemory(v, batch.stageMemory);
+
+		if (batch.stageBuffer) {
+			vkDestroyBuffer(v.device, batch.stageBuffer, nullptr);
+		}
+
+		if (batch.semaphore) {
+			vkDestroySemaphore(v.device, batch.semaphore, nullptr);
+		}
+
+		if (batch.fence) {
+			vkDestroyFence(v.device, batch.fence, nullptr);
+		}
+
+		vkFreeCommandBuffers(v.device, v.uploader.commandPool, 1, &batch.commandBuffer);
+	}
+
+	// Returns the batch currently recording if it has room for size more
+	// bytes, otherwise submits it and opens another one. A finished batch
+	// is reused only once its semaphore has been consumed by the graphics
+	// queue, since a binary semaphore can't be signaled twice unwaited.
+	UploadBatch& beginUploadBatch(Vulkan& v, VkDeviceSize size) {
+		Uploader& u = v.uploader;
+
+		if (u.current.has_value()) {
+			UploadBatch& batch = u.batches[u.current.value()];
+
+			if (batch.stageUsed + size <= batch.stageSize) {
+				return batch;
+			}
+
+			submitUploads(v);
+		}
+
+		for (size_t i = 0; i < u.batches.size(); i++) {
+			UploadBatch& batch = u.batches[i];
+
+			if (batch.stageSize < size) {
+				continue;
+			}
+
+			if (batch.submitted) {
+				if (!batch.semaphoreTaken || vkGetFenceStatus(v.device, batch.fence) != VK_SUCCESS) {
+					continue;
+				}
+
+				vkResetFences(v.device, 1, &batch.fence);
+			}
+
+			u.current = i;
+			break;
+		}
+
+		if (!u.current.has_value()) {
+			u.batches.push_back(UploadBatch());
+			initUploadBatch(v, u.batches.back(), std::max(size, uploadStageSize));
+			u.current = u.batches.size() - 1;
+		}
+
+		UploadBatch& batch = u.batches[u.current.value()];
+
+		VkCommandBufferBeginInfo bi = {};
+		bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(batch.commandBuffer, &bi);
+
+		batch.stageUsed = 0;
+		batch.recording = true;
+		batch.submitted = false;
+
+		return batch;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "../src/sim.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <map>
+#include <functional>
+
+
+// Times one tick of the AI paddle picked by difficulty three ways: a
+// std::map of std::function as the game used to, a std::map of AiParams,
+// and the table of per difficulty functions in sim. The matches mix every
+// difficulty so the table's indirect call can't always be predicted.
+//
+// ai_bench [--matches count] [--ticks count]
+
+typedef std::function<void(sim::Match& m, float delta)> AiFunction;
+
+// Moves the ball straight across and back with wall bounces, enough to make
+// the AI predict, wait and chase the way it does in a match.
+void moveBall(sim::Match& m, float delta) {
+	sim::Ball& b = m.ball;
+
+	b.position += b.velocity * b.speed * delta;
+
+	if (b.position.x < 0.0f || b.position.x + b.size.x > m.arena.x) {
+		b.velocity.x = -b.velocity.x;
+	}
+
+	if (b.position.y < 0.0f || b.position.y + b.size.y > m.arena.y) {
+		b.velocity.y = -b.velocity.y;
+	}
+}
+
+void initMatches(std::vector<sim::Match>& matches, uint32_t count) {
+	matches.resize(count);
+
+	for (uint32_t i = 0; i < count; i++) {
+		sim::Match& m = matches[i];
+		sim::initMatch(m, glm::vec2(640.0f, 480.0f), (sim::AiPlayerType)(i % sim::AiPlayerType::AI_PLAYER_COUNT), i + 1);
+
+		m.ball.speed = glm::vec2(256.0f, 128.0f);
+	}
+}
+
+template<typename T>
+double timeIt(std::vector<sim::Match>& matches, uint32_t ticks, float delta, T fn) {
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t t = 0; t < ticks; t++) {
+		for (auto& m : matches) {
+			fn(m);
+			moveBall(m, delta);
+		}
+	}
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	uint32_t count = 1024;
+	uint32_t ticks = 20000;
+
+	for (int i = 1; i < argc; i++) {
+		std::string cmd(argv[i]);
+
+		if (cmd == "--matches" && i + 1 < argc) {
+			count = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--ticks" && i + 1 < argc) {
+			ticks = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else {
+			std::cout << "AI: unknown argument " << cmd << std::endl;
+			return 1;
+		}
+	}
+
+	const float delta = 1.0f / 120.0f;
+
+	std::map<sim::AiPlayerType, AiFunction> aiFunctions;
+	std::map<sim::AiPlayerType, sim::AiParams> aiParams;
+
+	for (uint32_t i = 0; i < sim::AiPlayerType::AI_PLAYER_COUNT; i++) {
+		sim::AiParams params = sim::aiParams[i];
+
+		aiFunctions[(sim::AiPlayerType)i] = [params](sim::Match& m, float delta) {
+			sim::updatePaddleAi(m, m.aiPlayer, m.aiPlayerState, params, false, delta);
+		};
+
+		aiParams[(sim::AiPlayerType)i] = params;
+	}
+
+	std::vector<sim::Match> matches;
+	double updates = (double)count * ticks;
+
+	initMatches(matches, count);
+	double baseTime = timeIt(matches, ticks, delta, [&](sim::Match&) {});
+
+	std::cout << "AI: " << count << " matches x " << ticks << " ticks, moving the balls alone "
+		<< baseTime / updates * 1e9 << " ns/tick" << std::endl;
+
+	// The check sums where the paddles ended up, it is the same for every
+	// version and keeps the compiler from dropping any of them.
+	auto report = [&](const char* name, double time) {
+		double check = 0.0;
+
+		for (auto& m : matches) {
+			check += m.aiPlayer.position.y;
+		}
+
+		std::cout << "AI: " << name << " " << (time - baseTime) / updates * 1e9 << " ns/tick (check " << check << ")" << std::endl;
+	};
+
+	initMatches(matches, count);
+	report("map of std::function", timeIt(matches, ticks, delta, [&](sim::Match& m) {
+		aiFunctions[m.aiPlayerType](m, delta);
+	}));
+
+	initMatches(matches, count);
+	report("map of params", timeIt(matches, ticks, delta, [&](sim::Match& m) {
+		sim::updatePaddleAi(m, m.aiPlayer, m.aiPlayerState, aiParams[m.aiPlayerType], false, delta);
+	}));
+
+	initMatches(matches, count);
+	report("compiled table", timeIt(matches, ticks, delta, [&](sim::Match& m) {
+		sim::updatePaddleAi(m, m.aiPlayer, m.aiPlayerState, m.aiPlayerType, false, delta);
+	}));
+
+	return 0;
+}
\ No newline at end of file
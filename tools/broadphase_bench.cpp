@@ -0,0 +1,150 @@
+#include "../src/spatial_hash.h"
+
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+
+
+// Moves n boxes around a wrapping world for a number of ticks, updating the
+// spatial hash and finding the overlapping pairs every tick. The world grows
+// with n so density, and so pairs per object, stay the same at every count.
+// Up to 10k the pairs are checked against the all pairs batch test, and it
+// exits non-zero if they differ.
+//
+// broadphase_bench [--ticks count]
+
+struct Mover {
+	glm::vec2 position;
+	glm::vec2 velocity;
+};
+
+double seconds(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool bench(uint32_t count, uint32_t ticks) {
+	std::mt19937 rng(count);
+
+	const float world = std::sqrt((float)count) * 64.0f;
+	const float delta = 1.0f / 60.0f;
+
+	std::uniform_real_distribution<float> position(0.0f, world);
+	std::uniform_real_distribution<float> size(8.0f, 32.0f);
+	std::uniform_real_distribution<float> velocity(-120.0f, 120.0f);
+
+	util::SpatialHash hash;
+	util::initSpatialHash(hash, 64.0f);
+
+	std::vector<Mover> movers(count);
+
+	for (auto& m : movers) {
+		m.position = glm::vec2(position(rng), position(rng));
+		m.velocity = glm::vec2(velocity(rng), velocity(rng));
+		util::addObject(hash, m.position, glm::vec2(size(rng), size(rng)));
+	}
+
+	std::vector<std::pair<uint32_t, uint32_t>> pairs;
+
+	double updateTime = 0.0;
+	double pairTime = 0.0;
+	uint64_t pairCount = 0;
+	uint64_t cellMoves = 0;
+
+	for (uint32_t t = 0; t < ticks; t++) {
+		auto start = std::chrono::steady_clock::now();
+
+		for (uint32_t i = 0; i < count; i++) {
+			Mover& m = movers[i];
+			m.position += m.velocity * delta;
+
+			if (m.position.x < 0.0f) m.position.x += world;
+			if (m.position.x > world) m.position.x -= world;
+			if (m.position.y < 0.0f) m.position.y += world;
+			if (m.position.y > world) m.position.y -= world;
+
+			util::moveObject(hash, i, m.position);
+		}
+
+		cellMoves += hash.cellMoves;
+		updateTime += seconds(start);
+
+		start = std::chrono::steady_clock::now();
+
+		pairs.clear();
+		util::findPairs(hash, pairs);
+
+		pairTime += seconds(start);
+		pairCount += pairs.size();
+	}
+
+	std::cout << "Broadphase: " << count << " objects update " << updateTime / ticks * 1e3 << " ms"
+		<< " pairs " << pairTime / ticks * 1e3 << " ms"
+		<< " (" << pairCount / ticks << " pairs, " << cellMoves / ticks << " cell moves per tick)" << std::endl;
+
+	if (count > 10000) {
+		return true;
+	}
+
+	// The same last tick with every box against every other
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::pair<uint32_t, uint32_t>> all;
+	util::collideBoxes(hash.boxes, hash.boxes, all);
+
+	double allTime = seconds(start);
+
+	// Each pair once with the lower id first, like findPairs
+	std::vector<std::pair<uint32_t, uint32_t>> expected;
+
+	for (auto& p : all) {
+		if (p.first < p.second) {
+			expected.push_back(p);
+		}
+	}
+
+	std::vector<std::pair<uint32_t, uint32_t>> found = pairs;
+
+	std::sort(expected.begin(), expected.end());
+	std::sort(found.begin(), found.end());
+
+	// Compared pair by pair, the right count could still hide wrong pairs
+	std::vector<std::pair<uint32_t, uint32_t>> missing;
+	std::vector<std::pair<uint32_t, uint32_t>> extra;
+
+	std::set_difference(expected.begin(), expected.end(), found.begin(), found.end(), std::back_inserter(missing));
+	std::set_difference(found.begin(), found.end(), expected.begin(), expected.end(), std::back_inserter(extra));
+
+	bool same = missing.empty() && extra.empty();
+
+	std::cout << "Broadphase: " << count << " objects all pairs " << allTime * 1e3 << " ms (" << expected.size() << " pairs, ";
+
+	if (same) {
+		std::cout << "match)" << std::endl;
+	}
+	else {
+		std::cout << "MISMATCH, " << missing.size() << " missing and " << extra.size() << " extra)" << std::endl;
+	}
+
+	return same;
+}
+
+int main(int argc, char** argv) {
+	uint32_t ticks = 100;
+
+	for (int i = 1; i < argc; i++) {
+		std::string cmd(argv[i]);
+
+		if (cmd == "--ticks" && i + 1 < argc) {
+			ticks = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+	}
+
+	bool same = bench(1000, ticks);
+	same = bench(10000, ticks) && same;
+	same = bench(100000, ticks) && same;
+
+	return same ? 0 : 2;
+}
\ No newline at end of file
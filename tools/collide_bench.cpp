@@ -0,0 +1,149 @@
+#include "../src/rect.h"
+
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+
+// Times the batch box tests of rect.h at every level the CPU supports
+// against one Rect::isCollide call per pair, one box against 1k, 100k and
+// 1M boxes and then 1k boxes against 1k.
+
+struct Scene {
+	std::vector<util::Rect> rects;
+	util::Boxes boxes;
+};
+
+void initScene(Scene& scene, uint32_t count, std::mt19937& rng) {
+	// The world grows with the count so a query hits about as many boxes
+	float world = std::sqrt((float)count) * 64.0f;
+	std::uniform_real_distribution<float> position(0.0f, world);
+	std::uniform_real_distribution<float> size(4.0f, 32.0f);
+
+	for (uint32_t i = 0; i < count; i++) {
+		util::Rect r;
+		r.init(glm::vec2(position(rng), position(rng)), glm::vec2(size(rng), size(rng)));
+
+		scene.rects.push_back(r);
+		util::addBox(scene.boxes, r.position, r.size);
+	}
+}
+
+template<typename T>
+double timeIt(uint32_t runs, T fn) {
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < runs; i++) {
+		fn(i);
+	}
+
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void benchOne(uint32_t count, std::mt19937& rng) {
+	Scene scene;
+	initScene(scene, count, rng);
+
+	// About 100M box tests per path
+	uint32_t runs = std::max(100000000u / count, 1u);
+	std::vector<util::Rect> queries;
+
+	for (uint32_t i = 0; i < runs; i++) {
+		queries.push_back(scene.rects[rng() % count]);
+	}
+
+	std::vector<uint32_t> hits(count);
+	uint64_t found = 0;
+
+	double pairTime = timeIt(runs, [&](uint32_t q) {
+		uint32_t n = 0;
+
+		for (uint32_t i = 0; i < count; i++) {
+			if (queries[q].isCollide(scene.rects[i])) {
+				hits[n++] = i;
+			}
+		}
+
+		found += n;
+	});
+
+	double tests = (double)runs * count;
+
+	std::cout << "Collide: 1 x " << count << " per pair " << pairTime / tests * 1e9 << " ns/test ("
+		<< found << " hits)" << std::endl;
+
+	for (uint32_t level = 0; level <= util::CollideLevel::COLLIDE_AVX2; level++) {
+		util::setCollideLevel((util::CollideLevel)level);
+
+		if (util::getCollideLevel() != level) {
+			continue;
+		}
+
+		uint64_t batchFound = 0;
+
+		double time = timeIt(runs, [&](uint32_t q) {
+			batchFound += util::collideBoxes(queries[q], scene.boxes, hits.data());
+		});
+
+		std::cout << "Collide: 1 x " << count << " " << util::toString(util::getCollideLevel()) << " "
+			<< time / tests * 1e9 << " ns/test, " << pairTime / time << "x ("
+			<< batchFound << " hits)" << std::endl;
+	}
+}
+
+void benchMany(uint32_t count, std::mt19937& rng) {
+	Scene a;
+	Scene b;
+	initScene(a, count, rng);
+	initScene(b, count, rng);
+
+	const uint32_t runs = 10;
+	std::vector<std::pair<uint32_t, uint32_t>> pairs;
+
+	double pairTime = timeIt(runs, [&](uint32_t) {
+		pairs.clear();
+
+		for (uint32_t i = 0; i < count; i++) {
+			for (uint32_t j = 0; j < count; j++) {
+				if (a.rects[i].isCollide(b.rects[j])) {
+					pairs.push_back(std::make_pair(i, j));
+				}
+			}
+		}
+	});
+
+	std::cout << "Collide: " << count << " x " << count << " per pair " << pairTime / runs * 1e3 << " ms ("
+		<< pairs.size() << " pairs)" << std::endl;
+
+	for (uint32_t level = 0; level <= util::CollideLevel::COLLIDE_AVX2; level++) {
+		util::setCollideLevel((util::CollideLevel)level);
+
+		if (util::getCollideLevel() != level) {
+			continue;
+		}
+
+		double time = timeIt(runs, [&](uint32_t) {
+			pairs.clear();
+			util::collideBoxes(a.boxes, b.boxes, pairs);
+		});
+
+		std::cout << "Collide: " << count << " x " << count << " " << util::toString(util::getCollideLevel()) << " "
+			<< time / runs * 1e3 << " ms, " << pairTime / time << "x (" << pairs.size() << " pairs)" << std::endl;
+	}
+}
+
+int main() {
+	std::mt19937 rng(1);
+
+	std::cout << "Collide: cpu supports " << util::toString(util::getCollideLevel()) << std::endl;
+
+	benchOne(1000, rng);
+	benchOne(100000, rng);
+	benchOne(1000000, rng);
+
+	benchMany(1000, rng);
+
+	return 0;
+}
\ No newline at end of file
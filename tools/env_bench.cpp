@@ -0,0 +1,131 @@
+#include "../src/pong_env.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+
+// Steps the C API's environments with a policy that follows the ball,
+// timing them with one thread and with --threads, and checks both runs
+// wrote exactly the same observations, rewards and done flags.
+//
+// env_bench [--envs count] [--steps count] [--threads count] [--ai type] [--frame-skip ticks]
+
+struct Run {
+	PongEnvStats stats;
+	double won = 0.0;
+	double lost = 0.0;
+	// Of every observation, reward and done flag written
+	uint32_t hash = 2166136261u;
+};
+
+void hashBytes(Run& run, const void* data, size_t size) {
+	const uint8_t* bytes = (const uint8_t*)data;
+
+	for (size_t i = 0; i < size; i++) {
+		run.hash = (run.hash ^ bytes[i]) * 16777619u;
+	}
+}
+
+bool runEnv(PongEnvConfig config, uint32_t steps, Run& run) {
+	PongEnv* env = pong_env_create(&config);
+
+	if (!env) {
+		return false;
+	}
+
+	uint32_t count = pong_env_count(env);
+
+	std::vector<float> observations((size_t)count * PONG_ENV_OBSERVATION_SIZE);
+	std::vector<float> rewards(count);
+	std::vector<uint8_t> dones(count);
+	std::vector<uint8_t> actions(count);
+
+	pong_env_reset(env, observations.data());
+
+	for (uint32_t s = 0; s < steps; s++) {
+		// Towards the ball, from the last observation
+		for (uint32_t i = 0; i < count; i++) {
+			const float* o = &observations[(size_t)i * PONG_ENV_OBSERVATION_SIZE];
+			float gap = o[5] - o[0];
+
+			actions[i] = (gap < -0.02f) ? PONG_ENV_ACTION_UP : (gap > 0.02f) ? PONG_ENV_ACTION_DOWN : PONG_ENV_ACTION_NONE;
+		}
+
+		pong_env_step(env, actions.data(), observations.data(), rewards.data(), dones.data());
+
+		for (uint32_t i = 0; i < count; i++) {
+			run.won += std::max(rewards[i], 0.0f);
+			run.lost -= std::min(rewards[i], 0.0f);
+		}
+
+		hashBytes(run, observations.data(), observations.size() * sizeof(float));
+		hashBytes(run, rewards.data(), rewards.size() * sizeof(float));
+		hashBytes(run, dones.data(), dones.size());
+	}
+
+	pong_env_get_stats(env, &run.stats);
+	pong_env_destroy(env);
+
+	return true;
+}
+
+void report(const char* name, const Run& run, uint32_t frameSkip) {
+	std::cout << "Env: " << name << " " << (uint64_t)run.stats.stepsPerSecond << " steps/s, "
+		<< (uint64_t)(run.stats.stepsPerSecond * frameSkip) << " ticks/s, "
+		<< run.stats.episodes << " episodes ended, " << run.won << " points won and " << run.lost << " lost" << std::endl;
+}
+
+int main(int argc, char** argv) {
+	PongEnvConfig config;
+	pong_env_default_config(&config);
+
+	uint32_t steps = 2000;
+
+	for (int i = 1; i < argc; i++) {
+		std::string cmd(argv[i]);
+
+		if (cmd == "--envs" && i + 1 < argc) {
+			config.count = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--steps" && i + 1 < argc) {
+			steps = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--threads" && i + 1 < argc) {
+			config.threads = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--ai" && i + 1 < argc) {
+			config.aiPlayerType = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--frame-skip" && i + 1 < argc) {
+			config.frameSkip = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else {
+			std::cout << "Env: unknown argument " << cmd << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "Env: " << config.count << " envs, " << steps << " steps, " << config.frameSkip << " ticks a step" << std::endl;
+
+	PongEnvConfig single = config;
+	single.threads = 1;
+
+	Run one;
+	Run many;
+
+	if (!runEnv(single, steps, one) || !runEnv(config, steps, many)) {
+		std::cout << "Env: invalid config" << std::endl;
+		return 1;
+	}
+
+	report("1 thread", one, config.frameSkip);
+	report("all threads", many, config.frameSkip);
+
+	bool same = (one.hash == many.hash);
+	std::cout << "Env: " << (same ? "both runs wrote the same data" : "runs differ") << std::endl;
+
+	return same ? 0 : 2;
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "../src/net.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+
+// Plays a two player match over loopback UDP in one process, a session on
+// each side with bots holding keys the way people do, through a link with
+// the given latency, jitter and loss. Reports how much each side had to
+// roll back and checks both ended up playing the same match.
+//
+// netplay [--seconds count] [--latency ms] [--jitter ms] [--loss percent]
+//         [--delay ticks] [--rollback ticks] [--port port] [--tick-rate count]
+
+struct Bot {
+	sim::Rng rng;
+	uint32_t input = sim::Input::INPUT_NONE;
+};
+
+// Holds a key for a quarter second or so, then picks again
+uint32_t nextInput(Bot& bot) {
+	if (bot.rng() % 30 == 0) {
+		bot.input = bot.rng() % 3;
+	}
+
+	return bot.input;
+}
+
+void report(const char* name, const net::Session& s, double seconds) {
+	const net::SessionStats& st = s.stats;
+
+	std::cout << "Netplay: " << name << " " << st.ticks << " ticks, "
+		<< st.rollbacks / seconds << " rollbacks/s, "
+		<< st.resimulatedTicks << " ticks resimulated ("
+		<< ((st.rollbacks > 0) ? (double)st.resimulatedTicks / st.rollbacks : 0.0) << " a rollback), "
+		<< st.stalls << " stalls, " << st.skips << " skips" << std::endl;
+
+	std::cout << "Netplay: " << name << " " << st.predictions << " of " << st.remoteInputs << " remote inputs guessed, "
+		<< st.mispredictions << " wrong ("
+		<< ((st.predictions > 0) ? 100.0 * st.mispredictions / st.predictions : 0.0) << "%), correction mean "
+		<< ((st.rollbacks > 0) ? st.correction / st.rollbacks : 0.0) << " px max " << st.maxCorrection << " px" << std::endl;
+
+	std::cout << "Netplay: " << name << " packets " << st.packetsSent << " sent, " << st.packetsDropped << " dropped, "
+		<< st.packetsReceived << " received, checkpoints " << st.checks << " matched, " << st.desyncs << " desynced" << std::endl;
+}
+
+int main(int argc, char** argv) {
+	double seconds = 10.0;
+	net::LinkConditions link;
+	uint32_t inputDelay = 2;
+	uint32_t maxRollback = 32;
+	uint16_t port = 27960;
+	uint32_t tickRate = 120;
+
+	for (int i = 1; i < argc; i++) {
+		std::string cmd(argv[i]);
+
+		if (cmd == "--seconds" && i + 1 < argc) {
+			seconds = std::stod(argv[++i]);
+		}
+		else if (cmd == "--latency" && i + 1 < argc) {
+			link.latency = std::stof(argv[++i]) / 1000.0f;
+		}
+		else if (cmd == "--jitter" && i + 1 < argc) {
+			link.jitter = std::stof(argv[++i]) / 1000.0f;
+		}
+		else if (cmd == "--loss" && i + 1 < argc) {
+			link.loss = std::stof(argv[++i]) / 100.0f;
+		}
+		else if (cmd == "--delay" && i + 1 < argc) {
+			inputDelay = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--rollback" && i + 1 < argc) {
+			maxRollback = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--port" && i + 1 < argc) {
+			port = (uint16_t)std::stoul(argv[++i]);
+		}
+		else if (cmd == "--tick-rate" && i + 1 < argc) {
+			tickRate = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else {
+			std::cout << "Netplay: unknown argument " << cmd << std::endl;
+			return 1;
+		}
+	}
+
+	const float delta = 1.0f / tickRate;
+
+	net::SessionConfig left;
+	left.localPort = port;
+	left.remote.ip = 0x7f000001;
+	left.remote.port = port + 1;
+	left.left = true;
+	left.seed = 1;
+	left.inputDelay = inputDelay;
+	left.maxRollback = maxRollback;
+	left.link = link;
+
+	net::SessionConfig right = left;
+	right.localPort = port + 1;
+	right.remote.port = port;
+	right.left = false;
+
+	net::Session leftSession;
+	net::Session rightSession;
+
+	try {
+		net::initSession(leftSession, left);
+		net::initSession(rightSession, right);
+	}
+	catch (std::exception& e) {
+		std::cout << "Netplay: " << e.what() << std::endl;
+		return 1;
+	}
+
+	Bot leftBot;
+	leftBot.rng = sim::makeRng(11);
+	Bot rightBot;
+	rightBot.rng = sim::makeRng(12);
+
+	auto start = std::chrono::steady_clock::now();
+	auto tickTime = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / tickRate));
+	uint64_t ticks = (uint64_t)(seconds * tickRate);
+	uint32_t events;
+
+	for (uint64_t t = 0; t < ticks; t++) {
+		// A bot keeps its key down while its session waits, like a person
+		if (net::advanceSession(leftSession, leftBot.input, delta, events)) {
+			nextInput(leftBot);
+		}
+
+		if (net::advanceSession(rightSession, rightBot.input, delta, events)) {
+			nextInput(rightBot);
+		}
+
+		std::this_thread::sleep_until(start + tickTime * (t + 1));
+	}
+
+	// Let the last packets land so the final checkpoints get compared
+	auto settle = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<float>(link.latency + link.jitter + 0.1f));
+
+	while (std::chrono::steady_clock::now() < settle) {
+		net::pollSession(leftSession);
+		net::pollSession(rightSession);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	std::cout << "Netplay: " << seconds << " seconds at " << tickRate << " ticks/s, latency " << link.latency * 1000.0f
+		<< " ms, jitter " << link.jitter * 1000.0f << " ms, loss " << link.loss * 100.0f << "%, input delay "
+		<< inputDelay << " ticks" << std::endl;
+
+	report("left", leftSession, seconds);
+	report("right", rightSession, seconds);
+
+	std::cout << "Netplay: score " << leftSession.match.playerScore << " - " << leftSession.match.aiPlayerScore << std::endl;
+
+	uint64_t desyncs = leftSession.stats.desyncs + rightSession.stats.desyncs;
+	uint64_t checks = leftSession.stats.checks + rightSession.stats.checks;
+
+	net::releaseSession(leftSession);
+	net::releaseSession(rightSession);
+
+	return (desyncs == 0 && checks > 0) ? 0 : 2;
+}
\ No newline at end of file
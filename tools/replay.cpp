@@ -0,0 +1,96 @@
+#include "../src/replay.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <thread>
+
+
+// Plays a log written by run --record or simulate --record without a
+// window, Vulkan or audio, and checks the match ends where the recording
+// did. By default as fast as the CPU allows, --speed plays it that many
+// times faster than it was recorded.
+//
+// replay file [--speed times]
+
+int main(int argc, char** argv) {
+	std::string path;
+	double speed = 0.0;
+
+	for (int i = 1; i < argc; i++) {
+		std::string cmd(argv[i]);
+
+		if (cmd == "--speed" && i + 1 < argc) {
+			speed = std::stod(argv[++i]);
+		}
+		else if (path.empty()) {
+			path = cmd;
+		}
+		else {
+			std::cout << "Replay: unknown argument " << cmd << std::endl;
+			return 1;
+		}
+	}
+
+	if (path.empty()) {
+		std::cout << "Replay: replay file [--speed times]" << std::endl;
+		return 1;
+	}
+
+	replay::Player player;
+
+	try {
+		replay::openPlayer(player, path);
+	}
+	catch (std::exception& e) {
+		std::cout << "Replay: " << e.what() << std::endl;
+		return 1;
+	}
+
+	sim::Match match;
+	replay::initMatch(match, player.header);
+
+	uint32_t input;
+	glm::vec2 arena;
+	float delta;
+	double gameTime = 0.0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	while (replay::nextTick(player, input, arena, delta)) {
+		match.arena = arena;
+		sim::step(match, input, delta);
+
+		gameTime += delta;
+
+		if (speed > 0.0) {
+			std::this_thread::sleep_until(start + std::chrono::duration<double>(gameTime / speed));
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::string playerName = player.header.playerAi ? std::string("player (") + sim::toString(player.header.playerType) + ")" : "player";
+
+	std::cout << "Replay: " << playerName << " " << match.playerScore
+		<< " - " << match.aiPlayerScore << " ai player (" << sim::toString(player.header.aiPlayerType) << ")" << std::endl;
+	std::cout << "Replay: " << match.tick << " ticks (" << gameTime << " game seconds) in " << seconds << " seconds, "
+		<< match.tick / seconds << " ticks/s" << std::endl;
+
+	int result = 0;
+
+	if (!player.hasHash) {
+		std::cout << "Replay: log cut short, nothing to check the end against" << std::endl;
+	}
+	else if (player.hash == replay::hashMatch(match)) {
+		std::cout << "Replay: ended where the recording did" << std::endl;
+	}
+	else {
+		std::cout << "Replay: desync, ended somewhere else than the recording" << std::endl;
+		result = 2;
+	}
+
+	replay::closePlayer(player);
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "../src/sim.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+
+
+// Times saving and restoring a sim::Snapshot, and a rollback as netcode
+// would do one: every tick the match is rewound rollback ticks, stepped
+// forward again with the same input and checked against where it was.
+//
+// rollback_bench [--ticks count] [--rollback ticks] [--ring count]
+
+// Where rollback has to get back to, the rng included
+bool sameState(const sim::Match& a, const sim::Match& b) {
+	return
+		a.tick == b.tick &&
+		a.playerScore == b.playerScore &&
+		a.aiPlayerScore == b.aiPlayerScore &&
+		a.rng.state == b.rng.state &&
+		a.player.position == b.player.position &&
+		a.aiPlayer.position == b.aiPlayer.position &&
+		a.ball.position == b.ball.position &&
+		a.ball.velocity == b.ball.velocity &&
+		a.ball.speed == b.ball.speed &&
+		a.playerState.aim == b.playerState.aim &&
+		a.aiPlayerState.aim == b.aiPlayerState.aim &&
+		a.aiPlayerState.reaction == b.aiPlayerState.reaction;
+}
+
+int main(int argc, char** argv) {
+	uint32_t ticks = 200000;
+	uint32_t rollback = 8;
+	uint32_t ringSize = 128;
+
+	for (int i = 1; i < argc; i++) {
+		std::string cmd(argv[i]);
+
+		if (cmd == "--ticks" && i + 1 < argc) {
+			ticks = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--rollback" && i + 1 < argc) {
+			rollback = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--ring" && i + 1 < argc) {
+			ringSize = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else {
+			std::cout << "Rollback: unknown argument " << cmd << std::endl;
+			return 1;
+		}
+	}
+
+	if (rollback >= ringSize || rollback >= ticks) {
+		std::cout << "Rollback: --rollback has to be less than --ring and --ticks" << std::endl;
+		return 1;
+	}
+
+	const float delta = 1.0f / 120.0f;
+
+	// The player holds a key for a while, then another, like a person
+	sim::Rng rng = sim::makeRng(7);
+	std::vector<uint32_t> inputs(ticks);
+	uint32_t input = sim::Input::INPUT_NONE;
+
+	for (uint32_t t = 0; t < ticks; t++) {
+		if (rng() % 30 == 0) {
+			input = rng() % 3;
+		}
+
+		inputs[t] = input;
+	}
+
+	sim::Match match;
+	sim::initMatch(match, glm::vec2(640.0f, 480.0f), sim::AiPlayerType::AI_PLAYER_HARD, 1);
+
+	sim::SnapshotRing ring;
+	sim::initSnapshotRing(ring, ringSize);
+
+	std::cout << "Rollback: snapshot " << sizeof(sim::Snapshot) << " bytes, ring of " << ringSize << " "
+		<< sizeof(sim::Snapshot) * ringSize / 1024.0 << " KB" << std::endl;
+
+	// Save and restore on their own
+	const uint32_t copies = 10000000;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < copies; i++) {
+		match.tick = i;
+		sim::pushSnapshot(ring, match);
+	}
+
+	double saveTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < copies; i++) {
+		sim::rewindSnapshot(ring, match, copies - 1 - (i % ringSize));
+	}
+
+	double restoreTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Rollback: save " << saveTime / copies * 1e9 << " ns, restore " << restoreTime / copies * 1e9 << " ns" << std::endl;
+
+	// Rollback every tick
+	sim::initMatch(match, glm::vec2(640.0f, 480.0f), sim::AiPlayerType::AI_PLAYER_HARD, 1);
+	sim::initSnapshotRing(ring, ringSize);
+
+	std::vector<double> times;
+	uint32_t mismatches = 0;
+	double stepTime = 0.0;
+
+	for (uint32_t t = 0; t < ticks; t++) {
+		start = std::chrono::steady_clock::now();
+
+		sim::pushSnapshot(ring, match);
+		sim::step(match, inputs[t], delta);
+
+		stepTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (match.tick < rollback) {
+			continue;
+		}
+
+		sim::Match expected = match;
+
+		start = std::chrono::steady_clock::now();
+
+		uint64_t from = match.tick - rollback;
+
+		if (!sim::rewindSnapshot(ring, match, from)) {
+			std::cout << "Rollback: tick " << from << " missing from the ring" << std::endl;
+			return 1;
+		}
+
+		for (uint64_t r = from; r < expected.tick; r++) {
+			sim::pushSnapshot(ring, match);
+			sim::step(match, inputs[r], delta);
+		}
+
+		times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+		if (!sameState(match, expected)) {
+			mismatches++;
+			match = expected;
+		}
+	}
+
+	std::sort(times.begin(), times.end());
+
+	double total = 0.0;
+	for (double time : times) {
+		total += time;
+	}
+
+	double mean = total / times.size();
+	double p99 = times[times.size() * 99 / 100];
+	double worst = times.back();
+
+	std::cout << "Rollback: one tick " << stepTime / ticks * 1e9 << " ns" << std::endl;
+	std::cout << "Rollback: restore and " << rollback << " ticks, mean " << mean * 1e6 << " us, p99 " << p99 * 1e6
+		<< " us, worst " << worst * 1e6 << " us, " << (uint64_t)(1e-3 / mean) << " of them fit in 1 ms" << std::endl;
+	std::cout << "Rollback: " << times.size() << " rollbacks, " << mismatches << " ended somewhere else than the first time" << std::endl;
+
+	// The worst case is usually the OS taking the core away, p99 is what
+	// the budget has to hold for.
+	return (mismatches == 0 && p99 < 1e-3) ? 0 : 2;
+}
\ No newline at end of file
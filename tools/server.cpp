@@ -0,0 +1,140 @@
+#include "../src/server.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <csignal>
+
+
+// Hosts matches for clients over UDP until --seconds run out or Ctrl+C,
+// printing every --report seconds how many there are, how long ticks take
+// and how many matches a core could hold at that rate.
+//
+// server [--port port] [--threads count] [--tick-rate count]
+//        [--send-interval ticks] [--seconds count] [--report seconds]
+
+std::atomic<bool> interrupted{ false };
+
+void onInterrupt(int) {
+	interrupted = true;
+}
+
+void report(const server::ShardStats& stats, double seconds, uint32_t shards) {
+	std::vector<float> times = stats.tickTimes;
+	std::sort(times.begin(), times.end());
+
+	float p50 = times.empty() ? 0.0f : times[times.size() / 2];
+	float p99 = times.empty() ? 0.0f : times[times.size() * 99 / 100];
+	float worst = times.empty() ? 0.0f : times.back();
+
+	// Cores kept busy on average, and matches a core at that rate
+	double cores = stats.busy / seconds;
+	double perCore = (cores > 0.0) ? stats.matches / cores : 0.0;
+
+	std::cout << "Server: " << stats.matches << " matches on " << shards << " shards, "
+		<< stats.joins << " joined, " << stats.leaves << " left, " << stats.timeouts << " timed out" << std::endl;
+
+	std::cout << "Server: tick p50 " << p50 * 1e6f << " us, p99 " << p99 * 1e6f << " us, worst " << worst * 1e6f << " us, "
+		<< cores << " cores busy, " << (uint64_t)perCore << " matches a core" << std::endl;
+
+	std::cout << "Server: " << (uint64_t)(stats.packetsIn / seconds) << " packets/s in, "
+		<< (uint64_t)(stats.packetsOut / seconds) << " out, "
+		<< ((stats.packetsOut > 0) ? (double)stats.bytesOut / stats.packetsOut : 0.0) << " bytes a state, "
+		<< ((stats.packetsOut > 0) ? 100.0 * stats.fullStates / stats.packetsOut : 0.0) << "% full" << std::endl;
+}
+
+int main(int argc, char** argv) {
+	server::Config config;
+	double seconds = 0.0;
+	double reportInterval = 1.0;
+
+	for (int i = 1; i < argc; i++) {
+		std::string cmd(argv[i]);
+
+		if (cmd == "--port" && i + 1 < argc) {
+			config.port = (uint16_t)std::stoul(argv[++i]);
+		}
+		else if (cmd == "--threads" && i + 1 < argc) {
+			config.threads = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--tick-rate" && i + 1 < argc) {
+			config.tickRate = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--send-interval" && i + 1 < argc) {
+			config.sendInterval = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--seconds" && i + 1 < argc) {
+			seconds = std::stod(argv[++i]);
+		}
+		else if (cmd == "--report" && i + 1 < argc) {
+			reportInterval = std::max(std::stod(argv[++i]), 0.1);
+		}
+		else {
+			std::cout << "Server: unknown argument " << cmd << std::endl;
+			return 1;
+		}
+	}
+
+	std::signal(SIGINT, onInterrupt);
+	std::signal(SIGTERM, onInterrupt);
+
+	server::Server s;
+
+	try {
+		server::startServer(s, config);
+	}
+	catch (std::exception& e) {
+		std::cout << "Server: " << e.what() << std::endl;
+		server::stopServer(s);
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto last = start;
+
+	// Tick times over the whole run, for the summary at the end
+	server::ShardStats total;
+	server::ShardStats stats;
+	uint64_t peakMatches = 0;
+
+	bool done = false;
+
+	while (!done) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+		auto now = std::chrono::steady_clock::now();
+		double elapsed = std::chrono::duration<double>(now - last).count();
+
+		// The last report covers whatever is left since the one before
+		done = interrupted || (seconds > 0.0 && std::chrono::duration<double>(now - start).count() >= seconds);
+
+		if (elapsed < reportInterval && !done) {
+			continue;
+		}
+
+		last = now;
+		server::takeStats(s, stats);
+		report(stats, elapsed, (uint32_t)s.shards.size());
+
+		peakMatches = std::max(peakMatches, stats.matches);
+		total.ticks += stats.ticks;
+		total.busy += stats.busy;
+		total.tickTimes.insert(total.tickTimes.end(), stats.tickTimes.begin(), stats.tickTimes.end());
+	}
+
+	uint32_t shards = (uint32_t)s.shards.size();
+	server::stopServer(s);
+
+	std::sort(total.tickTimes.begin(), total.tickTimes.end());
+
+	if (!total.tickTimes.empty()) {
+		std::cout << "Server: " << total.ticks << " shard ticks, at most " << peakMatches << " matches on " << shards
+			<< " shards, tick p50 " << total.tickTimes[total.tickTimes.size() / 2] * 1e6f
+			<< " us, p99 " << total.tickTimes[total.tickTimes.size() * 99 / 100] * 1e6f
+			<< " us, p99.9 " << total.tickTimes[total.tickTimes.size() * 999 / 1000] * 1e6f << " us" << std::endl;
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,384 @@
+#include "../src/server.h"
+#include "../src/net.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+
+// Plays thousands of bot clients against a running server, each in a
+// match of its own, spread over a few threads that each send from a
+// handful of sockets. Prints how many states came back, how big they
+// were and the round trip from an input leaving to the state carrying
+// its echo arriving, which includes waiting for the server's next tick.
+//
+// server_load [--server host:port] [--clients count] [--threads count]
+//             [--sockets count] [--seconds count] [--tick-rate count] [--ai type]
+
+// Packets read or written per recvmmsg / sendmmsg call
+const uint32_t batchSize = 64;
+
+// States a bot keeps to apply deltas to, as many as the server keeps
+const uint32_t botHistory = server::stateHistory;
+
+struct Bot {
+	uint32_t token = 0;
+	uint32_t socket = 0;
+	bool joined = false;
+	uint32_t ack = server::noTick;
+	// State for tick t at t % botHistory, whatever the server's send interval
+	server::State states[botHistory];
+};
+
+struct LoadStats {
+	uint64_t packetsOut = 0;
+	uint64_t states = 0;
+	uint64_t fullStates = 0;
+	uint64_t bytesIn = 0;
+	// Deltas against a state the bot no longer had
+	uint64_t missingBase = 0;
+	uint64_t joined = 0;
+	uint64_t scores = 0;
+	std::vector<float> roundTrips;
+};
+
+struct Worker {
+	std::vector<int> sockets;
+	int epoll = -1;
+	int timer = -1;
+	std::vector<Bot> bots;
+	uint32_t firstToken = 0;
+	LoadStats stats;
+	std::thread thread;
+};
+
+uint32_t nowMicros() {
+	return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Follows the ball like a person who isn't trying too hard
+uint8_t botInput(const Bot& bot) {
+	if (bot.ack == server::noTick) {
+		return sim::Input::INPUT_NONE;
+	}
+
+	const server::State& state = bot.states[bot.ack % botHistory];
+	float paddle = server::getField(state, server::Field::FIELD_PLAYER_Y);
+	float ball = server::getField(state, server::Field::FIELD_BALL_Y);
+
+	// Paddle and ball sizes aren't sent, keep the ball's top within the
+	// middle half of a 64 pixel paddle. y grows downwards.
+	if (ball > paddle + 48.0f) {
+		return sim::Input::INPUT_DOWN;
+	}
+	else if (ball < paddle + 16.0f) {
+		return sim::Input::INPUT_UP;
+	}
+
+	return sim::Input::INPUT_NONE;
+}
+
+void sendAll(Worker& w, const sockaddr_in& to, server::Message type, uint8_t aiPlayerType) {
+	uint8_t buffers[batchSize][server::clientPacketSize];
+	iovec iovs[batchSize];
+	mmsghdr messages[batchSize];
+
+	// Bots are dealt to sockets in turn, bots s, s + sockets ... go out together
+	for (uint32_t s = 0; s < w.sockets.size(); s++) {
+		uint32_t queued = 0;
+
+		for (uint32_t b = s; b < w.bots.size(); b += (uint32_t)w.sockets.size()) {
+			Bot& bot = w.bots[b];
+
+			server::ClientPacket packet;
+			packet.type = (type == server::Message::MESSAGE_INPUT && !bot.joined) ? server::Message::MESSAGE_JOIN : type;
+			packet.token = bot.token;
+			packet.ack = bot.ack;
+			packet.echo = nowMicros();
+			packet.input = botInput(bot);
+			packet.aiPlayerType = aiPlayerType;
+
+			size_t size = server::writeClientPacket(buffers[queued], packet);
+
+			iovs[queued].iov_base = buffers[queued];
+			iovs[queued].iov_len = size;
+			messages[queued] = {};
+			messages[queued].msg_hdr.msg_iov = &iovs[queued];
+			messages[queued].msg_hdr.msg_iovlen = 1;
+			messages[queued].msg_hdr.msg_name = (void*)&to;
+			messages[queued].msg_hdr.msg_namelen = sizeof(to);
+			queued++;
+
+			if (queued == batchSize || b + w.sockets.size() >= w.bots.size()) {
+				int sent = sendmmsg(w.sockets[s], messages, queued, 0);
+				w.stats.packetsOut += (sent > 0) ? sent : 0;
+				queued = 0;
+			}
+		}
+	}
+}
+
+void receiveAll(Worker& w, int socket) {
+	uint8_t buffers[batchSize][server::maxStatePacketSize];
+	iovec iovs[batchSize];
+	mmsghdr messages[batchSize];
+
+	while (true) {
+		for (uint32_t i = 0; i < batchSize; i++) {
+			iovs[i].iov_base = buffers[i];
+			iovs[i].iov_len = sizeof(buffers[i]);
+			messages[i] = {};
+			messages[i].msg_hdr.msg_iov = &iovs[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		int count = recvmmsg(socket, messages, batchSize, 0, nullptr);
+
+		if (count <= 0) {
+			return;
+		}
+
+		uint32_t now = nowMicros();
+
+		for (int i = 0; i < count; i++) {
+			server::StatePacket packet;
+
+			if (!server::readState(buffers[i], messages[i].msg_len, packet)) {
+				continue;
+			}
+
+			uint32_t index = packet.token - w.firstToken;
+
+			if (index >= w.bots.size()) {
+				continue;
+			}
+
+			Bot& bot = w.bots[index];
+			w.stats.states++;
+			w.stats.bytesIn += messages[i].msg_len;
+			w.stats.roundTrips.push_back((now - packet.echo) * 1e-6f);
+
+			server::State& state = bot.states[packet.tick % botHistory];
+
+			if (packet.baseTick == server::noTick) {
+				server::applyState(packet, state, state);
+				w.stats.fullStates++;
+			}
+			else {
+				const server::State& base = bot.states[packet.baseTick % botHistory];
+
+				if (base.tick != packet.baseTick) {
+					w.stats.missingBase++;
+					continue;
+				}
+
+				// The base may be the slot being written, copy it first
+				server::State copy = base;
+				server::applyState(packet, copy, state);
+			}
+
+			if (!bot.joined) {
+				bot.joined = true;
+				w.stats.joined++;
+			}
+
+			if (packet.events & (sim::Event::EVENT_PLAYER_SCORE | sim::Event::EVENT_AI_PLAYER_SCORE)) {
+				w.stats.scores++;
+			}
+
+			if (bot.ack == server::noTick || (int32_t)(packet.tick - bot.ack) > 0) {
+				bot.ack = packet.tick;
+			}
+		}
+
+		if (count < (int)batchSize) {
+			return;
+		}
+	}
+}
+
+void runWorker(Worker& w, const sockaddr_in& to, double seconds, uint8_t aiPlayerType) {
+	auto end = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(seconds));
+
+	epoll_event events[16];
+
+	while (std::chrono::steady_clock::now() < end) {
+		int count = epoll_wait(w.epoll, events, 16, 100);
+
+		for (int i = 0; i < count; i++) {
+			if (events[i].data.fd == w.timer) {
+				uint64_t expirations;
+
+				if (read(w.timer, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+					sendAll(w, to, server::Message::MESSAGE_INPUT, aiPlayerType);
+				}
+			}
+			else {
+				receiveAll(w, events[i].data.fd);
+			}
+		}
+	}
+
+	sendAll(w, to, server::Message::MESSAGE_LEAVE, aiPlayerType);
+}
+
+int main(int argc, char** argv) {
+	std::string address = "127.0.0.1:27900";
+	uint32_t clients = 4000;
+	uint32_t threads = 4;
+	uint32_t socketsPerThread = 16;
+	double seconds = 10.0;
+	uint32_t tickRate = 60;
+	uint8_t aiPlayerType = sim::AiPlayerType::AI_PLAYER_NORMAL;
+
+	for (int i = 1; i < argc; i++) {
+		std::string cmd(argv[i]);
+
+		if (cmd == "--server" && i + 1 < argc) {
+			address = argv[++i];
+		}
+		else if (cmd == "--clients" && i + 1 < argc) {
+			clients = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--threads" && i + 1 < argc) {
+			threads = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--sockets" && i + 1 < argc) {
+			socketsPerThread = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--seconds" && i + 1 < argc) {
+			seconds = std::stod(argv[++i]);
+		}
+		else if (cmd == "--tick-rate" && i + 1 < argc) {
+			tickRate = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--ai" && i + 1 < argc) {
+			aiPlayerType = (uint8_t)std::min((uint32_t)std::stoul(argv[++i]), (uint32_t)sim::AiPlayerType::AI_PLAYER_COUNT - 1);
+		}
+		else {
+			std::cout << "Load: unknown argument " << cmd << std::endl;
+			return 1;
+		}
+	}
+
+	net::Address server;
+
+	if (!net::parseAddress(address, server)) {
+		std::cout << "Load: " << address << " is not host:port" << std::endl;
+		return 1;
+	}
+
+	sockaddr_in to = {};
+	to.sin_family = AF_INET;
+	to.sin_addr.s_addr = htonl(server.ip);
+	to.sin_port = htons(server.port);
+
+	threads = std::min(threads, clients);
+
+	// Tokens from a different range every run, so a server still holding
+	// the last run's matches doesn't hand them out again.
+	uint32_t tokenBase = nowMicros() & 0xfff00000;
+	std::vector<Worker> workers(threads);
+
+	long period = 1000000000L / tickRate;
+	itimerspec spec = {};
+	spec.it_interval.tv_sec = period / 1000000000L;
+	spec.it_interval.tv_nsec = period % 1000000000L;
+	spec.it_value = spec.it_interval;
+
+	for (uint32_t t = 0; t < threads; t++) {
+		Worker& w = workers[t];
+		uint32_t first = clients * t / threads;
+		uint32_t last = clients * (t + 1) / threads;
+
+		w.firstToken = tokenBase + first;
+		w.bots.resize(last - first);
+
+		for (uint32_t b = 0; b < w.bots.size(); b++) {
+			w.bots[b].token = w.firstToken + b;
+		}
+
+		w.epoll = epoll_create1(0);
+		w.timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+		timerfd_settime(w.timer, 0, &spec, nullptr);
+
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.fd = w.timer;
+		epoll_ctl(w.epoll, EPOLL_CTL_ADD, w.timer, &event);
+
+		for (uint32_t s = 0; s < std::min(socketsPerThread, (uint32_t)w.bots.size()); s++) {
+			int socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_UDP);
+
+			if (socket < 0) {
+				std::cout << "Load: failed to create socket" << std::endl;
+				return 1;
+			}
+
+			int size = 4 * 1024 * 1024;
+			setsockopt(socket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+			setsockopt(socket, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+			event.data.fd = socket;
+			epoll_ctl(w.epoll, EPOLL_CTL_ADD, socket, &event);
+
+			w.sockets.push_back(socket);
+		}
+	}
+
+	std::cout << "Load: " << clients << " clients on " << threads << " threads against " << address << " for "
+		<< seconds << " seconds, " << tickRate << " inputs/s each" << std::endl;
+
+	for (Worker& w : workers) {
+		w.thread = std::thread([&w, &to, seconds, aiPlayerType]() { runWorker(w, to, seconds, aiPlayerType); });
+	}
+
+	LoadStats total;
+
+	for (Worker& w : workers) {
+		w.thread.join();
+
+		total.packetsOut += w.stats.packetsOut;
+		total.states += w.stats.states;
+		total.fullStates += w.stats.fullStates;
+		total.bytesIn += w.stats.bytesIn;
+		total.missingBase += w.stats.missingBase;
+		total.joined += w.stats.joined;
+		total.scores += w.stats.scores;
+		total.roundTrips.insert(total.roundTrips.end(), w.stats.roundTrips.begin(), w.stats.roundTrips.end());
+
+		for (int socket : w.sockets) {
+			close(socket);
+		}
+
+		close(w.timer);
+		close(w.epoll);
+	}
+
+	std::sort(total.roundTrips.begin(), total.roundTrips.end());
+
+	std::cout << "Load: " << total.joined << " of " << clients << " clients got a match, " << total.scores << " points scored" << std::endl;
+	std::cout << "Load: " << (uint64_t)(total.packetsOut / seconds) << " inputs/s out, "
+		<< (uint64_t)(total.states / seconds) << " states/s in, "
+		<< ((total.states > 0) ? (double)total.bytesIn / total.states : 0.0) << " bytes a state, "
+		<< ((total.states > 0) ? 100.0 * total.fullStates / total.states : 0.0) << "% full, "
+		<< total.missingBase << " deltas on a state already gone" << std::endl;
+
+	if (!total.roundTrips.empty()) {
+		std::cout << "Load: round trip p50 " << total.roundTrips[total.roundTrips.size() / 2] * 1e3f
+			<< " ms, p99 " << total.roundTrips[total.roundTrips.size() * 99 / 100] * 1e3f
+			<< " ms, worst " << total.roundTrips.back() * 1e3f << " ms" << std::endl;
+	}
+
+	return (total.joined == clients) ? 0 : 2;
+}
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "../src/sim.h"
+
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <cmath>
+
+
+// Checks of sim's rules that a change to the AI or the ball could quietly
+// break. Prints every check and exits non-zero if any failed.
+//
+// sim_check [--seeds count]
+
+// The AI lets a ball past, then the serve comes straight back at it. It has
+// to aim for the new ball rather than where the old one was going.
+bool checkServeAfterConceding(uint32_t seeds) {
+	const float delta = 1.0f / 120.0f;
+	bool passed = true;
+
+	for (uint32_t t = sim::AiPlayerType::AI_PLAYER_HARD; t < sim::AiPlayerType::AI_PLAYER_COUNT; t++) {
+		sim::AiPlayerType type = (sim::AiPlayerType)t;
+		uint32_t returned = 0;
+
+		for (uint32_t seed = 1; seed <= seeds; seed++) {
+			sim::Match m;
+			sim::initMatch(m, glm::vec2(640.0f, 480.0f), type, seed);
+
+			// Heading for the bottom right corner with the AI sure it goes top
+			m.ball.position = glm::vec2(m.arena.x - 64.0f, m.arena.y - m.ball.size.y - 8.0f);
+			m.ball.velocity = glm::vec2(1.0f, 1.0f);
+			m.aiPlayer.position.y = 0.0f;
+			m.aiPlayerState.tracking = true;
+			m.aiPlayerState.aim = m.aiPlayer.size.y * 0.5f;
+			m.aiPlayerState.reaction = 0.0f;
+
+			uint32_t events = sim::Event::EVENT_NONE;
+
+			for (uint32_t i = 0; i < 120 * 60 && !(events & sim::Event::EVENT_PLAYER_SCORE); i++) {
+				events = sim::step(m, sim::Input::INPUT_NONE, delta);
+			}
+
+			if (!(events & sim::Event::EVENT_PLAYER_SCORE)) {
+				continue;
+			}
+
+			// Served towards the side that just conceded
+			m.ball.velocity.x = 1.0f;
+
+			for (uint32_t i = 0; i < 120 * 60; i++) {
+				events = sim::step(m, sim::Input::INPUT_NONE, delta);
+
+				if (m.ball.velocity.x < 0.0f) {
+					returned++;
+					break;
+				}
+
+				if (events & sim::Event::EVENT_PLAYER_SCORE) {
+					break;
+				}
+			}
+		}
+
+		// A serve is slow and the AI has all the time it needs to get there,
+		// the noisy difficulties may still misjudge the odd one.
+		uint32_t required = (type == sim::AiPlayerType::AI_PLAYER_IMPOSSIBLE) ? seeds : seeds * 9 / 10;
+		bool ok = returned >= required;
+		passed = passed && ok;
+
+		std::cout << "Check: " << sim::toString(type) << " returned " << returned << " of " << seeds
+			<< " serves right after conceding " << (ok ? "ok" : "FAILED") << std::endl;
+	}
+
+	return passed;
+}
+
+// What a pairing adds up to over many matches, from Match or the Batch
+struct Pairing {
+	uint64_t points = 0;
+	uint64_t hits = 0;
+	uint64_t playerWins = 0;
+	uint64_t aiPlayerWins = 0;
+};
+
+// The Batch doesn't play tick for tick like Match, but over many matches
+// the same pairing has to come out the same, or whatever is measured with
+// it says nothing about the game.
+bool checkBatchAgrees(uint32_t seeds) {
+	const float delta = 1.0f / 120.0f;
+	const uint64_t ticks = 120 * 60 * 20;
+	const uint32_t points = 5;
+	const glm::vec2 arena(640.0f, 480.0f);
+
+	// Left against right, impossible against itself never scores
+	const sim::AiPlayerType pairings[][2] = {
+		{ sim::AiPlayerType::AI_PLAYER_EASY, sim::AiPlayerType::AI_PLAYER_EASY },
+		{ sim::AiPlayerType::AI_PLAYER_NORMAL, sim::AiPlayerType::AI_PLAYER_NORMAL },
+		{ sim::AiPlayerType::AI_PLAYER_HARD, sim::AiPlayerType::AI_PLAYER_HARD },
+		{ sim::AiPlayerType::AI_PLAYER_EXPERT, sim::AiPlayerType::AI_PLAYER_EASY },
+		{ sim::AiPlayerType::AI_PLAYER_HARD, sim::AiPlayerType::AI_PLAYER_IMPOSSIBLE }
+	};
+
+	bool passed = true;
+
+	for (const auto& pairing : pairings) {
+		Pairing match;
+
+		for (uint32_t seed = 1; seed <= seeds; seed++) {
+			sim::Match m;
+			sim::initMatch(m, arena, pairing[1], seed);
+			m.playerAi = true;
+			m.playerType = pairing[0];
+
+			uint32_t rally = 0;
+
+			for (uint64_t t = 0; t < ticks; t++) {
+				uint32_t events = sim::step(m, sim::Input::INPUT_NONE, delta);
+
+				if (events & sim::Event::EVENT_PADDLE_HIT) {
+					rally++;
+				}
+
+				if (!(events & (sim::Event::EVENT_PLAYER_SCORE | sim::Event::EVENT_AI_PLAYER_SCORE))) {
+					continue;
+				}
+
+				match.points++;
+				match.hits += rally;
+				rally = 0;
+
+				if (m.playerScore >= points || m.aiPlayerScore >= points) {
+					(m.playerScore > m.aiPlayerScore) ? match.playerWins++ : match.aiPlayerWins++;
+					m.playerScore = 0;
+					m.aiPlayerScore = 0;
+				}
+			}
+		}
+
+		sim::Batch b;
+		sim::initBatch(b, seeds, arena, points);
+
+		for (uint32_t i = 0; i < seeds; i++) {
+			sim::setBatchMatch(b, i, pairing[0], pairing[1], i + 1);
+		}
+
+		for (uint64_t t = 0; t < ticks; t++) {
+			sim::stepBatch(b, 0, seeds, delta);
+		}
+
+		Pairing batch;
+
+		for (const sim::BatchStats& stats : b.stats) {
+			batch.points += stats.points;
+			batch.hits += stats.hits;
+			batch.playerWins += stats.playerWins;
+			batch.aiPlayerWins += stats.aiPlayerWins;
+		}
+
+		double matchRally = (double)match.hits / std::max(match.points, (uint64_t)1);
+		double batchRally = (double)batch.hits / std::max(batch.points, (uint64_t)1);
+		double matchShare = (double)match.playerWins / std::max(match.playerWins + match.aiPlayerWins, (uint64_t)1);
+		double batchShare = (double)batch.playerWins / std::max(batch.playerWins + batch.aiPlayerWins, (uint64_t)1);
+
+		// Points come every few seconds and rallies vary a lot, a few seeds
+		// can't pin either down closer than this.
+		bool ok =
+			std::abs((double)batch.points - match.points) <= match.points * 0.15 &&
+			std::abs(batchRally - matchRally) <= matchRally * 0.15 &&
+			std::abs(batchShare - matchShare) <= 0.15;
+		passed = passed && ok;
+
+		std::cout << "Check: " << sim::toString(pairing[0]) << " against " << sim::toString(pairing[1])
+			<< ", Match " << match.points << " points, rally " << matchRally << ", left won " << matchShare * 100.0 << "%"
+			<< ", Batch " << batch.points << " points, rally " << batchRally << ", left won " << batchShare * 100.0 << "% "
+			<< (ok ? "ok" : "FAILED") << std::endl;
+	}
+
+	return passed;
+}
+
+int main(int argc, char** argv) {
+	uint32_t seeds = 100;
+
+	for (int i = 1; i < argc; i++) {
+		std::string cmd(argv[i]);
+
+		if (cmd == "--seeds" && i + 1 < argc) {
+			seeds = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else {
+			std::cout << "Check: unknown argument " << cmd << std::endl;
+			return 1;
+		}
+	}
+
+	bool passed = checkServeAfterConceding(seeds);
+	passed = checkBatchAgrees(seeds) && passed;
+
+	return passed ? 0 : 2;
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "../src/sim.h"
+#include "../src/replay.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+
+// Plays the built in AI against itself with no window, Vulkan or audio, as
+// fast as the CPU allows, and reports the score and ticks per second.
+//
+// simulate [difficulty] [--player difficulty] [--ticks count] [--points count]
+//          [--seed seed] [--tick-rate count] [--record file]
+
+bool toAiPlayerType(const std::string& name, sim::AiPlayerType& type) {
+	for (uint32_t i = 0; i < sim::AiPlayerType::AI_PLAYER_COUNT; i++) {
+		if (name == sim::toString((sim::AiPlayerType)i)) {
+			type = (sim::AiPlayerType)i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int main(int argc, char** argv) {
+	sim::AiPlayerType aiPlayerType = sim::AiPlayerType::AI_PLAYER_EASY;
+	sim::AiPlayerType playerType = sim::AiPlayerType::AI_PLAYER_EXPERT;
+	uint64_t ticks = 0;
+	uint32_t points = 0;
+	uint32_t seed = 1;
+	uint32_t tickRate = 120;
+	std::string recordPath;
+
+	for (int i = 1; i < argc; i++) {
+		std::string cmd(argv[i]);
+
+		if (cmd == "--player" && i + 1 < argc) {
+			toAiPlayerType(argv[++i], playerType);
+		}
+		else if (cmd == "--ticks" && i + 1 < argc) {
+			ticks = std::stoull(argv[++i]);
+		}
+		else if (cmd == "--points" && i + 1 < argc) {
+			points = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--seed" && i + 1 < argc) {
+			seed = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--tick-rate" && i + 1 < argc) {
+			tickRate = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--record" && i + 1 < argc) {
+			recordPath = argv[++i];
+		}
+		else if (!toAiPlayerType(cmd, aiPlayerType)) {
+			std::cout << "Simulate: unknown argument " << cmd << std::endl;
+			return 1;
+		}
+	}
+
+	// Two strong AIs may never score, so points alone would run forever
+	if (ticks == 0 && points == 0) {
+		ticks = 10000000;
+	}
+
+	const float delta = 1.0f / tickRate;
+
+	replay::Header header;
+	header.seed = seed;
+	header.aiPlayerType = aiPlayerType;
+	header.playerAi = true;
+	header.playerType = playerType;
+	header.arena = glm::vec2(640.0f, 480.0f);
+	header.delta = delta;
+
+	sim::Match match;
+	replay::initMatch(match, header);
+
+	replay::Recorder recorder;
+
+	if (!recordPath.empty()) {
+		replay::openRecorder(recorder, recordPath, header);
+	}
+
+	uint64_t hits = 0;
+	uint64_t rally = 0;
+	uint64_t longestRally = 0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	while (true) {
+		if (ticks > 0 && match.tick >= ticks) {
+			break;
+		}
+
+		if (points > 0 && match.playerScore + match.aiPlayerScore >= points) {
+			break;
+		}
+
+		if (recorder.file) {
+			replay::recordTick(recorder, sim::Input::INPUT_NONE, match.arena, delta);
+		}
+
+		uint32_t events = sim::step(match, sim::Input::INPUT_NONE, delta);
+
+		if (events & sim::Event::EVENT_PADDLE_HIT) {
+			hits++;
+			rally++;
+		}
+
+		if (events & (sim::Event::EVENT_PLAYER_SCORE | sim::Event::EVENT_AI_PLAYER_SCORE)) {
+			longestRally = std::max(longestRally, rally);
+			rally = 0;
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	replay::closeRecorder(recorder, match);
+
+	uint32_t scored = match.playerScore + match.aiPlayerScore;
+
+	std::cout << "Simulate: player (" << sim::toString(playerType) << ") " << match.playerScore
+		<< " - " << match.aiPlayerScore << " ai player (" << sim::toString(aiPlayerType) << ")" << std::endl;
+
+	std::cout << "Simulate: " << match.tick << " ticks (" << (double)match.tick / tickRate << " game seconds) in "
+		<< seconds << " seconds, " << (uint64_t)(match.tick / std::max(seconds, 1e-9)) << " ticks/s" << std::endl;
+
+	std::cout << "Simulate: " << hits << " paddle hits, "
+		<< ((scored > 0) ? (double)hits / scored : 0.0) << " per point, longest rally " << longestRally << std::endl;
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "../src/sim.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+
+// Plays every difficulty against every other as many AI against AI matches
+// at once on all cores, and reports win rates and rally lengths.
+//
+// sweep [--matches count] [--ticks count] [--points count] [--seed seed]
+//       [--threads count] [--tick-rate count]
+
+int main(int argc, char** argv) {
+	uint32_t matches = 25000;
+	uint64_t ticks = 100000;
+	uint32_t points = 5;
+	uint32_t seed = 1;
+	uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+	uint32_t tickRate = 120;
+
+	for (int i = 1; i < argc; i++) {
+		std::string cmd(argv[i]);
+
+		if (cmd == "--matches" && i + 1 < argc) {
+			matches = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--ticks" && i + 1 < argc) {
+			ticks = std::stoull(argv[++i]);
+		}
+		else if (cmd == "--points" && i + 1 < argc) {
+			points = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--seed" && i + 1 < argc) {
+			seed = std::stoul(argv[++i]);
+		}
+		else if (cmd == "--threads" && i + 1 < argc) {
+			threads = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else if (cmd == "--tick-rate" && i + 1 < argc) {
+			tickRate = std::max((uint32_t)std::stoul(argv[++i]), 1u);
+		}
+		else {
+			std::cout << "Sweep: unknown argument " << cmd << std::endl;
+			return 1;
+		}
+	}
+
+	// The batch only tests for paddles after the ball moves
+	if (!(1.0f / tickRate < sim::batchMaxDelta)) {
+		std::cout << "Sweep: --tick-rate has to be over " << (uint32_t)(1.0f / sim::batchMaxDelta) << std::endl;
+		return 1;
+	}
+
+	const uint32_t types = sim::AiPlayerType::AI_PLAYER_COUNT;
+
+	// Lanes take the pairings in turn, so every pairing gets an even share
+	sim::Batch batch;
+	sim::initBatch(batch, matches, glm::vec2(640.0f, 480.0f), points);
+
+	for (uint32_t i = 0; i < matches; i++) {
+		uint32_t pairing = i % (types * types);
+		sim::setBatchMatch(batch, i, (sim::AiPlayerType)(pairing / types), (sim::AiPlayerType)(pairing % types), seed + i);
+	}
+
+	util::ThreadPool pool;
+	util::initThreadPool(pool, threads - 1);
+
+	auto start = std::chrono::steady_clock::now();
+
+	sim::runBatch(batch, pool, ticks, 1.0f / tickRate);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	util::releaseThreadPool(pool);
+
+	// Player x ai player, and each difficulty over both sides
+	std::vector<sim::BatchStats> pairings(types * types);
+	std::vector<uint64_t> wins(types, 0);
+	std::vector<uint64_t> played(types, 0);
+
+	for (uint32_t i = 0; i < matches; i++) {
+		const sim::BatchStats& s = batch.stats[i];
+		sim::BatchStats& p = pairings[batch.playerType[i] * types + batch.aiPlayerType[i]];
+
+		p.playerWins += s.playerWins;
+		p.aiPlayerWins += s.aiPlayerWins;
+		p.points += s.points;
+		p.hits += s.hits;
+		p.longestRally = std::max(p.longestRally, s.longestRally);
+
+		wins[batch.playerType[i]] += s.playerWins;
+		wins[batch.aiPlayerType[i]] += s.aiPlayerWins;
+		played[batch.playerType[i]] += s.playerWins + s.aiPlayerWins;
+		played[batch.aiPlayerType[i]] += s.playerWins + s.aiPlayerWins;
+	}
+
+	for (uint32_t p = 0; p < types; p++) {
+		for (uint32_t a = 0; a < types; a++) {
+			const sim::BatchStats& s = pairings[p * types + a];
+			uint64_t finished = s.playerWins + s.aiPlayerWins;
+
+			std::cout << "Sweep: " << sim::toString((sim::AiPlayerType)p) << " vs " << sim::toString((sim::AiPlayerType)a)
+				<< " matches " << finished
+				<< " player wins " << ((finished > 0) ? 100.0 * s.playerWins / finished : 0.0) << "%"
+				<< " rally " << ((s.points > 0) ? (double)s.hits / s.points : 0.0)
+				<< " longest " << s.longestRally << std::endl;
+		}
+	}
+
+	for (uint32_t t = 0; t < types; t++) {
+		std::cout << "Sweep: " << sim::toString((sim::AiPlayerType)t) << " wins "
+			<< ((played[t] > 0) ? 100.0 * wins[t] / played[t] : 0.0) << "% of " << played[t] << " matches" << std::endl;
+	}
+
+	double matchTicks = (double)matches * ticks;
+
+	std::cout << "Sweep: " << matches << " matches x " << ticks << " ticks on " << threads << " threads in "
+		<< seconds << " seconds, " << (uint64_t)(matchTicks / std::max(seconds, 1e-9)) << " match-ticks/s" << std::endl;
+
+	return 0;
+}
\ No newline at end of file